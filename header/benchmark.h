@@ -0,0 +1,37 @@
+#pragma once
+#include <string>
+
+
+// Offscreen benchmarks, run with: sparky --benchmark <name>
+namespace Benchmark
+{
+    // Runs the named benchmark, returns false if there's no such benchmark or it fails to run
+    bool run(const std::string& name);
+
+    // "render": times each of the map's tile render modes
+    bool runMapRender();
+
+    // "churn": times spawning and killing waves of mobs, and reports how much of the pools ended up used
+    bool runEntityChurn();
+
+    // "integrate": times moving every entity one at a time against the batched integrator, at 10k and 100k entities
+    bool runIntegration();
+
+    // "steering": times drag worked out one agent at a time with powf against the vectorised kernel, fails if they differ by more than the kernel allows
+    bool runSteering();
+
+    // "grid": times radius, box and nearest neighbour queries on the spatial grid against checking every entity, at 50k entities
+    bool runSpatialGrid();
+
+    // "bodies": times pushing apart crowds of agents that all head for the same point, fails if more than 5% of frames' collision goes over the per-frame budget
+    bool runBodyCollision();
+
+    // "crowd": times separation steering per agent for crowds of 100 to 10000 agents around one target
+    bool runSeparation();
+
+    // "snapshot": times saving and restoring every entity's state at 10k entities, fails if either is over budget, or the restore doesn't match or doesn't update like the original
+    bool runSnapshot();
+
+    // "lookup": adds components to entities in random orders and kills some, fails if hasComponent ever disagrees with what each entity was given
+    bool runComponentLookup();
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include "world.h"
+#include "spatial_grid.h"
+
+#include <SDL.h>
+
+#include <vector>
+
+
+class MechanicalComponent;
+
+// Pushes overlapping bodies (entities with a BodyComponent) apart, so agents don't stack on each other
+// Pairs are found with the spatial grid and checked box against box, each pair is separated along its shallow axis like walls are
+// Bodies that touch form an island, islands don't affect each other so they're solved on different threads
+class BodyCollider
+{
+public:
+    // Run after the bodies have moved and the grid has been rebuilt, before map collision so walls have the last say
+    void resolve(World& world, const SpatialGrid& grid);
+
+    // What the last resolve did
+    struct Stats
+    {
+        int mBodies = 0;
+        int mContacts = 0;
+        int mIslands = 0;
+        int mLargestIsland = 0;    // In contacts
+    };
+
+    const Stats& getStats() const { return mStats; }
+
+private:
+    struct Body
+    {
+        MechanicalComponent* mMechComp;
+        EntityHandle mHandle;
+        SDL_FRect mBox;         // Moved by the solver, written back to the component at the end
+        float mStartX;
+        float mStartY;
+        float mInverseMass;
+    };
+
+    struct Contact
+    {
+        int mA;
+        int mB;
+    };
+
+    std::vector<Body> mBodies;
+    std::vector<int> mBodyIndex;        // By entity id, -1 for entities that aren't bodies
+    std::vector<Contact> mContacts;
+
+    // Union-find over the bodies, bodies with the same root are in the same island
+    std::vector<int> mParents;
+    std::vector<int> mIslandOfRoot;     // By root body, -1 until the root's first contact
+
+    // Contacts sorted by island, island i is mIslandContacts[mIslandStarts[i]] up to mIslandContacts[mIslandStarts[i + 1]]
+    std::vector<Contact> mIslandContacts;
+    std::vector<int> mIslandStarts;
+    std::vector<int> mContactIslands;
+
+    Stats mStats;
+
+    void gatherBodies(World& world);
+    void findContacts(const SpatialGrid& grid);
+    void buildIslands();
+    void solveIsland(int island);
+
+    int findRoot(int body);
+};
@@ -0,0 +1,113 @@
+#pragma once
+#include "map_format.h"
+
+#include <SDL.h>
+
+#include <cstddef>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+
+namespace MapInternals
+{
+    // The decoded tiles of one square chunk of the map
+    struct Chunk
+    {
+        // Row major index of the chunk within the map
+        int mIndex = -1;
+
+        // Row major, chunk side length tiles per row
+        std::vector<Uint8> mTypes;
+
+        // 1 bit per tile, set if the tile is a wall
+        std::vector<Uint64> mWallBits;
+    };
+
+    // Streams the chunks of a compressed map in and out of memory
+    // A background thread decodes requested chunks ahead of use, the least recently used chunks are evicted to stay within the memory budget
+    // Lookups must be made from the thread that owns the cache, a chunk that isn't loaded yet is decoded on the spot
+    class ChunkCache
+    {
+    public:
+        ChunkCache() = delete;
+        // The map data must be a valid compressed map and outlive the cache
+        ChunkCache(const Uint8* mapData, std::size_t mapSize, std::size_t memoryBudget);
+        ChunkCache(const ChunkCache&) = delete;
+        ChunkCache& operator=(const ChunkCache&) = delete;
+        ~ChunkCache();
+
+        tileType getType(int row, int col) { return static_cast<tileType>(getChunk(row, col).mTypes[getOffset(row, col)]); }
+
+        bool isWall(int row, int col)
+        {
+            int offset = getOffset(row, col);
+            return (getChunk(row, col).mWallBits[offset >> 6] >> (offset & 63)) & 1;
+        }
+
+        // Queues the chunks overlapping a range of tiles for loading, chunks already in memory are marked as recently used
+        void request(int firstRow, int firstCol, int lastRow, int lastCol);
+
+        // Moves chunks finished by the loader into the cache and evicts chunks over the budget
+        void update();
+
+        int getResidentChunkCount() const { return static_cast<int>(mResident.size()); }
+        std::size_t getResidentBytes() const { return mResident.size() * mChunkBytes; }
+
+    private:
+        int mChunkSideLength;
+        int mChunksPerRow;
+
+        // Memory used by each chunk, and the number of chunks that fit in the budget
+        std::size_t mChunkBytes;
+        std::size_t mMaxResidentChunks;
+
+        const Uint8* mMapData;
+        std::size_t mMapSize;
+
+        // Chunks in memory, most recently used first
+        std::list<Chunk> mResident;
+        std::unordered_map<int, std::list<Chunk>::iterator> mResidentLookup;
+
+        // The last chunk looked up, most lookups hit the same chunk as the one before
+        int mLastIndex = -1;
+        const Chunk* mLastChunk = nullptr;
+
+        // Chunks queued for the loader that haven't been moved into the cache yet
+        std::unordered_set<int> mPending;
+
+        // Shared with the loader thread, guarded by mMutex
+        std::mutex mMutex;
+        std::condition_variable mLoaderWake;
+        std::deque<int> mRequests;
+        std::vector<Chunk> mFinished;
+        bool mQuit = false;
+
+        std::thread mLoader;
+
+        int getOffset(int row, int col) const { return (row % mChunkSideLength) * mChunkSideLength + col % mChunkSideLength; }
+
+        const Chunk& getChunk(int row, int col)
+        {
+            int index = (row / mChunkSideLength) * mChunksPerRow + col / mChunkSideLength;
+            if (index != mLastIndex)
+                findChunk(index);
+            return *mLastChunk;
+        }
+
+        // Makes a chunk the last chunk looked up, loading it if needed
+        void findChunk(int index);
+
+        // Adds a chunk as the most recently used one, then evicts the least recently used chunks over the budget
+        void insert(Chunk&& chunk);
+        void evict();
+
+        void decode(int index, Chunk& chunk) const;
+        void runLoader();
+    };
+}
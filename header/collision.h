@@ -17,4 +17,10 @@ bool checkCollision(const SDL_FRect& a, const SDL_FRect& b);
 // Finds the minimum vector needed to resolve all collisions on a axis aligned system
 void buildCollisionReport(const SDL_FRect& entity, const std::vector<SDL_Rect>& collidedTiles, Vec& adjustPos);
 
+// Adds a single collided box to the report, boxes can be added one at a time as they're found
+void addToCollisionReport(const SDL_FRect& entity, const SDL_Rect& collidedTile, Vec& adjustPos);
+
+// The shortest move along one axis that takes the entity out of the other box, the step the report is built from
+Vec findSeparation(const SDL_FRect& entity, const SDL_FRect& other);
+
 
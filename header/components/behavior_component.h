@@ -2,6 +2,7 @@
 #include "component.h"
 #include "../Pathfinder.h"
 #include "../entity.h"
+#include "../spatial_grid.h"
 #include "../vec.h"
 
 #include <SDL.h>
@@ -12,20 +13,41 @@ class BehaviorComponent : public Component
 {
 	public:
 	BehaviorComponent() = delete;
-	BehaviorComponent(Entity* owner, Pathfinder* pathfinder, const Entity* target, float accelForce, float maxVel, float dragCap);
-	BehaviorComponent(Entity* owner, Pathfinder* pathfinder, const Entity* target, float accelForce, float maxVel, float dragCap, const Vec& accel);
+	BehaviorComponent(Entity* owner, Pathfinder* pathfinder, EntityHandle target, float accelForce, float maxVel, float dragCap);
+	BehaviorComponent(Entity* owner, Pathfinder* pathfinder, EntityHandle target, float accelForce, float maxVel, float dragCap, const Vec& accel);
+	BehaviorComponent(BehaviorComponent&& other) noexcept;
 	virtual ~BehaviorComponent();
 
+	// Steers along the path to the target
 	void update1(float deltaTime) override;
+	// Records where the target ended up, other entities' components are only read once they've finished moving
+	void update3(float deltaTime) override;
+
+	// See SystemAccess
+	static void declareAccess(UpdatePhase phase, SystemAccess& access);
+
+	// See World::saveSnapshot, the target, path and repath timer
+	void saveState(SnapshotWriter& writer) const;
+	void loadState(SnapshotReader& reader);
+	static bool checkState(SnapshotReader& reader);
+
+	// Agents steer apart from the agents the grid finds near them, nullptr turns it off
+	// Only read while agents steer, the grid must be rebuilt between updates rather than during them
+	static void setSeparationGrid(const SpatialGrid* grid) { mSeparationGrid = grid; }
 
 	// Return false if path ends up empty
 	bool updatePath(float deltaTime);
 	bool advancePoint();
 
 private:
-	// Non-owning pointers
+	// Non-owning pointer
 	static inline Pathfinder* mPathfinder = nullptr;
-	const Entity* mTarget;
+	static inline const SpatialGrid* mSeparationGrid = nullptr;
+
+	// The entity being followed, stops following once it's destroyed
+	EntityHandle mTarget;
+	Vec mTargetPos{ 0.f, 0.f };
+	bool mHasTarget = false;    // False until the target's position is known, and once it's destroyed
 
 	float mAccelForce;      // The force the entity applies to accelerate
 
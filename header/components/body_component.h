@@ -0,0 +1,30 @@
+#pragma once
+#include "component.h"
+#include "../world.h"
+
+#include <stdexcept>
+
+
+// Marks an entity as a body that other bodies push out of the way, see BodyCollider
+// The entity must also have a MechanicalComponent, its collision box is the shape of the body
+class BodyComponent : public Component
+{
+public:
+	BodyComponent() = delete;
+	// A mass of 0 is never pushed, heavier bodies are pushed less by lighter ones
+	BodyComponent(Entity* owner, float mass = 1.f) : Component{ owner }, mInverseMass{ mass > 0.f ? 1.f / mass : 0.f }
+	{
+		if (mass < 0.f)
+			throw(std::invalid_argument{ "Error: Attempted to create a body with negative mass\n" });
+	}
+
+	virtual ~BodyComponent() {}
+
+	// See SystemAccess, bodies are moved by the BodyCollider, the component has nothing to run itself
+	static void declareAccess(UpdatePhase phase, SystemAccess& access) {}
+
+	float getInverseMass() const { return mInverseMass; }
+
+private:
+	float mInverseMass;
+};
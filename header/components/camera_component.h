@@ -5,20 +5,41 @@
 
 #include <SDL.h>
 
+#include <memory>
+
 
 class CameraComponent : public Component
 {
 public:
 	CameraComponent() = delete;
 	CameraComponent(Entity* owner, SDL_Window* window) : Component{ owner }, mWindow{ window }{}
+	CameraComponent(CameraComponent&&) = default;
 	virtual ~CameraComponent() = default;
 
 	// Center the camera over the player using linear interpolation
 	void update3(float deltaTime) override;
 
+	// See SystemAccess, the window is read through SDL
+	static void declareAccess(UpdatePhase phase, SystemAccess& access);
+
+	// Moves the drawn camera part of the way from where it was at the start of the last update to where it is now
+	// Until it's called the camera is drawn where the last update left it
+	void interpolate(float interpolation);
+
+	// See World::saveSnapshot
+	void saveState(SnapshotWriter& writer) const;
+	void loadState(SnapshotReader& reader);
+	static bool checkState(SnapshotReader& reader);
+
+	// The camera things are drawn relative to
 	SDL_FRect& getCamera();
 
 private:
 	SDL_Window* mWindow;    // Non-owning pointer
-	SDL_FRect mCamera{ 0.f,0.f,0.f,0.f };
+	// Kept on the heap so texture components can hold on to it while the component is moved
+	std::unique_ptr<SDL_FRect> mCamera{ new SDL_FRect{ 0.f,0.f,0.f,0.f } };
+
+	// Where updates leave the camera, the drawn camera is blended between them
+	SDL_FRect mPrevCamera{ 0.f, 0.f, 0.f, 0.f };
+	SDL_FRect mCurrentCamera{ 0.f, 0.f, 0.f, 0.f };
 };
\ No newline at end of file
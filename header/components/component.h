@@ -16,7 +16,8 @@ public:
 	virtual void update1(float deltaTime) {}
 	virtual void update2(float deltaTime) {}
 	virtual void update3(float deltaTime) {}
-	virtual void draw() {}
+	// Interpolation is how far the frame is between the last update and the next, from 0 to 1
+	virtual void draw(float interpolation) {}
 
 protected:
 	// Can only be created from a derived class
@@ -1,6 +1,7 @@
 #pragma once
 #include "component.h"
 #include "../entity.h"
+#include "mechanical_component.h"
 #include "../vec.h"
 
 #include <SDL.h>
@@ -18,6 +19,18 @@ public:
 	// Update acceleration and mechanical component
 	void update1(float deltaTime) override;
 
+	// See World::saveSnapshot, which keys are held down
+	void saveState(SnapshotWriter& writer) const;
+	void loadState(SnapshotReader& reader);
+	static bool checkState(SnapshotReader& reader);
+
+	// See SystemAccess
+	static void declareAccess(UpdatePhase phase, SystemAccess& access)
+	{
+		if (phase == UPDATE_1)
+			access.reads<MechanicalComponent>().writes<MechanicalComponent>();
+	}
+
 private:
 	SDL_Event* mEvent;            // non-owning pointer
 	float mAccelForce;            // The force the entity applies to accelerate
@@ -7,16 +7,40 @@
 #include <SDL.h>
 
 
+class MechanicalComponent;
+
 class MapCollisionComponent : public Component
 {
 public:
+	enum Mode
+	{
+		RESOLVE_OVERLAP,	// Pushes the entity out of the walls it ended up in
+		SWEPT				// Sweeps the entity from where it was to where it moved, so it can't pass through walls
+	};
+
 	MapCollisionComponent() = delete;
-	MapCollisionComponent(Entity* owner, Map* map) : Component{ owner }, mMap{ map }{}
+	MapCollisionComponent(Entity* owner, Map* map, Mode mode = RESOLVE_OVERLAP) : Component{ owner }, mMap{ map }, mMode{ mode }{}
 	virtual ~MapCollisionComponent() = default;
 
 	// Detect collison with map and update mechanical component
 	void update2(float deltaTime) override;
 
+	// See World::saveSnapshot, where the next sweep starts from
+	void saveState(SnapshotWriter& writer) const;
+	void loadState(SnapshotReader& reader);
+	static bool checkState(SnapshotReader& reader);
+
+	// See SystemAccess
+	static void declareAccess(UpdatePhase phase, SystemAccess& access);
+
 private:
 	Map* mMap;	// Non-owning pointer
+	Mode mMode;
+
+	// Where the entity was left after the last update, the start of the next sweep
+	Vec mLastPos{ 0.f, 0.f };
+	bool mHasLastPos = false;
+
+	// Moves the entity back along its path to where it first hit a wall, then slides it along the wall
+	void sweep(MechanicalComponent& mechComp);
 };
\ No newline at end of file
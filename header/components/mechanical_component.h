@@ -1,5 +1,6 @@
 #pragma once
 #include "Component.h"
+#include "../world.h"
 #include "../vec.h"
 
 #include <SDL.h>
@@ -15,10 +16,11 @@ public:
 	{
 		// Set initial position using the provided collision box
 		mPos = Vec{ mCollisionBox.x, mCollisionBox.y};
+		mPrevPos = mPos;
 	}
 	
 	MechanicalComponent(Entity* owner, const Vec& pos, const Vec& vel, const SDL_FRect& collisionBox) 
-		: Component{ owner }, mPos{ pos }, mVel{ vel }, mCollisionBox{ collisionBox }
+		: Component{ owner }, mPos{ pos }, mVel{ vel }, mCollisionBox{ collisionBox }, mPrevPos{ pos }
 	{
 		if (mPos.getX() != mCollisionBox.x || mPos.getY() != mCollisionBox.y)
 			throw(std::runtime_error{ "Error: Provided mechanical component with conflicting coordinates\n" });
@@ -26,21 +28,52 @@ public:
 
 	virtual ~MechanicalComponent() {}
 
+	// See SystemAccess, only integrates itself
+	static void declareAccess(UpdatePhase phase, SystemAccess& access)
+	{
+		if (phase == INTEGRATE)
+			access.runs();
+	}
+
+	// Moves a run of components by their velocity and acceleration, several at a time
+	// The world runs it once per update, after the steering components have set the acceleration
+	static void integrate(MechanicalComponent* rows, int count, float deltaTime);
+
+	// Moves the component on its own, the per-object version of integrate, drag is worked out with powf (see Steering::getDrag)
 	void update(float deltaTime, const Vec& accel);
 
+	// See World::saveSnapshot
+	void saveState(SnapshotWriter& writer) const;
+	void loadState(SnapshotReader& reader);
+	static bool checkState(SnapshotReader& reader);
+
+	// Acceleration and drag for the next integrate, cleared once they've been used
+	// Drag opposes the velocity, its magnitude is speed ^ exponent up to the cap
+	void setAccel(const Vec& accel);
+	void setDrag(float exponent, float cap);
+
 	void resetVel();            // Sets velocity to 0
+	void setVel(const Vec& vel);
 
 	void addToPos(const Vec& toAdd);
 	const Vec& getPos() const;
 	const Vec& getVel() const;
 	const SDL_FRect& getCollisionBox();
-	double getRotationAngle() const;
+	// The collision box part of the way from where it was at the start of the last update to where it is now
+	SDL_FRect getInterpolatedBox(float interpolation) const;
+	double getRotationAngle() const;    // Facing direction in degrees
 
 protected:
 	Vec mPos{ 0.f, 0.f };
 	Vec mVel{ 0.f, 0.f };
 	SDL_FRect mCollisionBox;    // Kept up-to-date with position
+	Vec mAccel{ 0.f, 0.f };
+	float mDragExponent = 0.f;
+	float mDragCap = 0.f;
+
+	// The last velocity that wasn't truncated, the rotation angle is only worked out from it when it's needed for drawing
+	Vec mFacing{ 0.f, 0.f };
 
-	// Facing direction
-	double mRotationAngle = 0.0;
+	// Position at the start of the last update, so drawing can blend between updates
+	Vec mPrevPos{ 0.f, 0.f };
 };
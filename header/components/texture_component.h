@@ -14,9 +14,14 @@ public:
 	TextureComponent() = delete;
 	TextureComponent(Entity* owner, const SDL_FRect* camera, Texture&& texture);
 	TextureComponent(Entity* owner, const SDL_FRect* camera, SDL_Renderer* defaultRenderer, std::string pathOrText, TTF_Font* defaultFont = nullptr, SDL_Color* textColor = nullptr);
+	TextureComponent(TextureComponent&& other) noexcept;
 	virtual ~TextureComponent();
+
+	// See SystemAccess, only draws
+	static void declareAccess(UpdatePhase phase, SystemAccess& access) {}
 	
-	void draw() override;
+	// Drawn between where the entity was at the start and end of the last update
+	void draw(float interpolation) override;
 
 private:
 	void initCamera(const SDL_FRect* camera);
@@ -56,6 +61,15 @@ public:
 		initCamera(camera);
 	}
 
+	// Components are moved when their entity changes archetype
+	SharedTextureComponent(SharedTextureComponent&& other) noexcept : Component{ other }
+	{
+		++mObjectCount;
+	}
+
+	// See SystemAccess, only draws
+	static void declareAccess(UpdatePhase phase, SystemAccess& access) {}
+
 	virtual ~SharedTextureComponent() 
 	{
 		if (mObjectCount == 1)	// If this is the last object
@@ -69,10 +83,10 @@ public:
 		--mObjectCount;
 	}
 
-	void draw() override
+	void draw(float interpolation) override
 	{
-		// Get collision box from mechanical component
-		const SDL_FRect& collisionBox = mOwner->getComponent<MechanicalComponent>().getCollisionBox();
+		// Get collision box from mechanical component, between where it was at the start and end of the last update
+		SDL_FRect collisionBox = mOwner->getComponent<MechanicalComponent>().getInterpolatedBox(interpolation);
 
 		float textureWidthOffset = (static_cast<float>(mTexture->getWidth()) - collisionBox.w) / 2.f;
 		float textureHeightOffset = (static_cast<float>(mTexture->getHeight()) - collisionBox.h) / 2.f;
@@ -1,8 +1,10 @@
 #pragma once
 #include "components/Component.h"
 #include "util.h"
+#include "world.h"
 
 #include <stdexcept>
+#include <utility>
 
 
 class missing_component : public std::runtime_error
@@ -19,89 +21,79 @@ public:
 };
 
 // Class design credit: https:// www.youtube.com/watch?v=XsvI8Sng6dk
+// The entity's components are stored in its world, grouped with the components of similar entities
+// Entities are created and destroyed by the world, see World::spawnEntity and kill
 class Entity
 {
 public:
-	Entity() {}
-	~Entity() {}
+	Entity() = delete;
+	Entity(const Entity&) = delete;
+	Entity& operator=(const Entity&) = delete;
 
+	// Use the world to run every entity at once, these only run this entity
 	void handleEvents()
 	{
-		for (auto& [key, value] : mComponents)
-		{
-			value->handleEvent();
-		}
+		mWorld.forEachComponent(mId, [](Component& component) { component.handleEvent(); });
 	}
 
 	void update(float deltaTime)
 	{
-		for (auto& [key, value] : mComponents)
-		{
-			value->update1(deltaTime);
-		}
-
-		for (auto& [key, value] : mComponents)
-		{
-			value->update2(deltaTime);
-		}
-		
-		for (auto& [key, value] : mComponents)
-		{
-			value->update3(deltaTime);
-		}
+		mWorld.forEachComponent(mId, [deltaTime](Component& component) { component.update1(deltaTime); });
+		mWorld.forEachComponent(mId, [deltaTime](Component& component) { component.update2(deltaTime); });
+		mWorld.forEachComponent(mId, [deltaTime](Component& component) { component.update3(deltaTime); });
 	}
 
-	void draw()
+	void draw(float interpolation)
 	{
-		for (auto& [key, value] : mComponents)
-		{
-			value->draw();
-		}
+		mWorld.forEachComponent(mId, [interpolation](Component& component) { component.draw(interpolation); });
 	}
 
 	bool isActive() const { return mAlive; }
-	void kill() { mAlive = false; }
+
+	// The entity is destroyed at the end of the world's update, use a handle to refer to an entity that might be killed
+	void kill()
+	{
+		mAlive = false;
+		mWorld.destroyLater(mId);
+	}
 
 	// Check if the entity has the specified component type
 	template<typename T> bool hasComponent() const
 	{
-		auto it = mComponents.find(IdGen<T>::getTypeID());
-		return (it == mComponents.end());
+		return mWorld.hasComponent<T>(mId);
 	}
 
 	// Fowarding ref
+	// Adding a component moves the entity's other components, references to them are invalidated
 	template<typename T, typename... Targs>
 	T& addComponent(Targs&&... args)
 	{
-		// Create specified component and provide pointer to this entity, and forward any other arguments this type needs
-		T* component(new T{ this, std::forward<Targs>(args)... });
-
-		// Create unique base class pointer (upcasting)
-		std::unique_ptr<Component> ptr{ component };
-
-		// Move the pointer into the entity's component map
-		mComponents.insert({ IdGen<T>::getTypeID(), std::move(ptr) });
-
-		// Return a reference to the newly added component
-		return *component;
+		// The world creates the component with a pointer to this entity, and forwards any other arguments this type needs
+		return mWorld.addComponent<T>(mId, std::forward<Targs>(args)...);
 	}
 
 	// Retrieve specified component
 	template<typename T> T& getComponent() const
 	{
-		// Get specified component from the map using its type id
-		auto it = mComponents.find(IdGen<T>::getTypeID());
+		T* component = mWorld.findComponent<T>(mId);
 
 		// Throw exception if the component doesn't exist
-		if (it == mComponents.end())
+		if (component == nullptr)
 			throw(missing_component{"Error: Attempted to retrieve a component that does not exist\n"});
 
-		Component* baseComponent = it->second.get();
-		// Downcast it to its actual type
-		return static_cast<T&>(*baseComponent);
+		return *component;
 	}
 
+	int getId() const { return mId; }
+	EntityHandle getHandle() const { return mWorld.getHandle(mId); }
+	World& getWorld() const { return mWorld; }
+
 private:
+	friend class World;
+	explicit Entity(World& world) : mWorld{ world }, mId{ world.createEntity(this) } {}
+	~Entity() { mWorld.destroyEntity(mId); }
+
 	bool mAlive = true;
-	std::unordered_map<typeID, std::unique_ptr<Component>> mComponents;
+	World& mWorld;
+	int mId;
 };
\ No newline at end of file
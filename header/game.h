@@ -3,10 +3,17 @@
 #include "../header/pathfinder.h"
 #include "../header/util.h"      // unique pointer
 #include "../header/entity.h"
+#include "../header/world.h"
+#include "../header/spatial_grid.h"
+#include "../header/body_collider.h"
+#include "../header/replay.h"
 
 #include <SDL_mixer.h>
 #include <SDL_ttf.h>
 
+#include <memory>
+#include <string>
+
 
 // Intilizes SDL
 class GameLoader
@@ -17,7 +24,10 @@ public:
     bool init();
     void close();
 protected:
-    GameLoader();
+    // Headless loaders don't open a window, renderer or audio, only what the simulation needs
+    explicit GameLoader(bool headless);
+
+    bool mHeadless;
 
     // Game primary window
     WindowPtr mWindow;
@@ -31,21 +41,50 @@ private:
 class Game : public GameLoader
 {
 public:
-    Game();
+    // Headless games run the same simulation with no window, renderer or audio, see simulate
+    explicit Game(bool headless = false);
     ~Game();
 
     bool loadAssets();
     void handleEvents();
+    // Runs as many fixed length ticks as the time since the last frame covers
     void update();
+    // Draws entities part of the way between the last tick and the next one
     void render();
     void freeAssets();
 
     bool isRunning();
 
+    // How many times a second the simulation ticks, independent of the frame rate
+    void setTickRate(float ticksPerSecond);
+
+    // Runs the given number of ticks as fast as possible instead of in real time, then prints how long they took
+    // Used headless, e.g. for server-side simulation and soak tests
+    void simulate(int ticks);
+
+    // Records the player's input and the state after every tick, written to the file when the game closes
+    void startRecording(const std::string& path);
+    // Plays recorded input back instead of the player's, at the tick rate it was recorded at, then stops the game
+    // Returns how many ticks were recorded, -1 if the replay couldn't be loaded
+    int startReplay(const std::string& path);
+
 private:
     bool mRunning = true;
     bool mPaused = false;
-    float mDeltaTime = 0.f;
+
+    // Length of a tick in seconds, and time that's passed but hasn't been simulated yet
+    float mTickLength;
+    float mAccumulator = 0.f;
+
+    // Ticks run so far, recorded input is tied to the tick it was applied before
+    int mTickCount = 0;
+
+    // At most one of each, nullptr when not recording or replaying
+    std::unique_ptr<InputRecorder> mRecorder;
+    std::unique_ptr<InputReplay> mReplay;
+
+    // Advances the simulation by one tick
+    void tick();
 
     // Primary font
     TTF_Font* mFont = nullptr;
@@ -68,8 +107,18 @@ private:
     // Holds the game map
     Pathfinder mMap;
 
-    Entity player;
-    Entity bob;
-    Entity sob;
+    // Finds the entities near a point, cells are the size of the map's tiles
+    SpatialGrid mEntityGrid{ static_cast<float>(mMap.getTileSideLength()) };
+
+    // Keeps entities from overlapping each other
+    BodyCollider mBodies;
+
+    // Owns every entity, updates components on every hardware thread
+    World mWorld{ JobSystem::getDefaultWorkerCount() };
+
+    // Owned by the world
+    Entity& player{ mWorld.spawnEntity() };
+    Entity& bob{ mWorld.spawnEntity() };
+    Entity& sob{ mWorld.spawnEntity() };
 };
 
@@ -0,0 +1,71 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+// A pool of worker threads that split loops between them
+// Each worker has its own queue of work, workers that run out take work from the front of the others' queues (work stealing)
+class JobSystem
+{
+public:
+    // 0 workers runs everything on the calling thread
+    explicit JobSystem(int workerCount);
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+    ~JobSystem();
+
+    // Calls the function with ranges of [0, count), at most grainSize long, and returns once every range is done
+    // The calling thread works on the ranges as well, the first exception thrown by the function is rethrown here
+    // Only one thread may call this at a time
+    void parallelFor(int count, int grainSize, const std::function<void(int begin, int end)>& function);
+
+    int getWorkerCount() const { return static_cast<int>(mWorkers.size()); }
+
+    // One worker per hardware thread, leaving one for the calling thread
+    static int getDefaultWorkerCount();
+
+private:
+    struct Job
+    {
+        int mBegin;
+        int mEnd;
+    };
+
+    // A worker's queue, the owner takes jobs from the back and thieves from the front
+    struct Queue
+    {
+        std::mutex mMutex;
+        std::deque<Job> mJobs;
+    };
+
+    // Queue 0 belongs to the calling thread, queue i + 1 to worker i
+    std::vector<std::unique_ptr<Queue>> mQueues;
+    std::vector<std::thread> mWorkers;
+
+    // The loop being run, set by parallelFor before any jobs are queued
+    const std::function<void(int, int)>* mFunction = nullptr;
+    std::atomic<int> mJobsLeft{ 0 };
+    std::exception_ptr mException;
+    std::mutex mExceptionMutex;
+
+    // Workers sleep until a loop starts
+    std::mutex mWakeMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    unsigned mLoopCount = 0;
+    bool mQuit = false;
+
+    void runWorker(int queueIndex);
+
+    // Runs jobs until there are none left to take
+    void runJobs(int queueIndex);
+    bool takeJob(int queueIndex, Job& job);
+};
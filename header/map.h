@@ -1,36 +1,116 @@
 #pragma once
 #include "texture.h"
+#include "util.h"      // For texture smart pointer
 #include "collision.h"
 #include "vec.h"
+#include "polygon.h"
+#include "map_format.h"
+#include "mapped_file.h"
+#include "chunk_cache.h"
 
 #include <SDL.h>
 
+#include <atomic>
 #include <memory>
 #include <vector>
+#include <string>
+#include <unordered_map>
 
 
 namespace MapInternals
 {
-    enum tileType : int { MISC_TILE, FLOOR_TILE, WALL_TILE, TOTAL_TILE_TYPES };
-
-    class Tile
+    // Row major grid of tile types stored in a single block of memory, or streamed in chunks for maps too large to hold at once
+    // A tile is identified by its index, its position and collision box are derived from the index when needed
+    class TileGrid
     {
     public:
-        Tile() = default;
-        ~Tile() = default;
+        TileGrid() = default;
+        TileGrid(const TileGrid&) = delete;
+        TileGrid& operator=(const TileGrid&) = delete;
+        ~TileGrid() = default;
+
+        // Resize the grid, every tile is set to the fill type
+        void assign(int widthInTiles, int heightInTiles, tileType fill);
+
+        // Use tile types and a wall bitmap stored elsewhere (e.g, a memory mapped map file) instead of owning them
+        // The wall bitmap must be laid out like a packed map's (see map_format.h), the memory must be writable and outlive the grid
+        void view(int widthInTiles, int heightInTiles, Uint8* types, Uint64* wallBits);
+
+        // Stream the tiles of a compressed map through a chunk cache, the map data must outlive the grid
+        void stream(int widthInTiles, int heightInTiles, const Uint8* mapData, std::size_t mapSize, std::size_t memoryBudget);
+
+        // Release the tiles, stops any streaming
+        void clear();
+
+        bool isStreamed() const { return mChunks != nullptr; }
+
+        // Streamed grids only, see ChunkCache
+        void request(int firstRow, int firstCol, int lastRow, int lastCol) { if (mChunks) mChunks->request(firstRow, firstCol, lastRow, lastCol); }
+        void update() { if (mChunks) mChunks->update(); }
 
-        // Initialize position and type
-        void setTile(int x, int y, int tileSideLength, tileType type);
+        // Grids held in memory only
+        void setType(int index, tileType type)
+        {
+            mTypes[index] = type;
 
-        tileType getType() const;
+            // Keep the wall bitmap in sync
+            int bit = getBorderedIndex(getRow(index), getCol(index));
+            if (type == WALL_TILE)
+                mWallBits[bit >> 6] |= (Uint64{ 1 } << (bit & 63));
+            else
+                mWallBits[bit >> 6] &= ~(Uint64{ 1 } << (bit & 63));
+        }
 
-        const SDL_Rect* getCollisionBox() const;
+        tileType getType(int index) const { return mChunks ? mChunks->getType(getRow(index), getCol(index)) : static_cast<tileType>(mTypes[index]); }
+        tileType getType(int row, int col) const { return mChunks ? mChunks->getType(row, col) : static_cast<tileType>(mTypes[getIndex(row, col)]); }
 
-        // Tile dimensions and position
-        SDL_Rect mCollisionBox = {0, 0, 0, 0};
+        // Wall checks read the bitmap, 64 tiles per cache-friendly word
+        bool isWall(int index) const { return isWall(getRow(index), getCol(index)); }
+        bool isWall(int row, int col) const { return mChunks ? mChunks->isWall(row, col) : isWallBit(row, col); }
+
+        // Also accepts the tiles in a 1 tile border around the grid, which are always walls
+        // Grids held in memory answer without any bounds checks
+        bool isWallOrBorder(int row, int col) const
+        {
+            if (mChunks)
+                return row < 0 || row >= mHeight || col < 0 || col >= mWidth || mChunks->isWall(row, col);
+
+            return isWallBit(row, col);
+        }
+
+        int getIndex(int row, int col) const { return row * mWidth + col; }
+        int getRow(int index) const { return index / mWidth; }
+        int getCol(int index) const { return index % mWidth; }
+
+        int getWidth() const { return mWidth; }
+        int getHeight() const { return mHeight; }
+        int size() const { return mWidth * mHeight; }
 
     private:
-        tileType mType = MISC_TILE;
+        int mWidth = 0;
+        int mHeight = 0;
+
+        // 1 byte per tile
+        Uint8* mTypes = nullptr;
+
+        // 1 bit per tile, set if the tile is a wall
+        // Padded with a 1 tile border of walls, so lookups just outside of the grid land on a wall instead of out of bounds
+        Uint64* mWallBits = nullptr;
+
+        // Backing storage, unused when viewing external memory
+        std::vector<Uint8> mOwnedTypes;
+        std::vector<Uint64> mOwnedWallBits;
+
+        // Set when streaming, the tiles live in the cache's chunks instead
+        std::unique_ptr<ChunkCache> mChunks;
+
+        // Index of a tile's bit in the wall bitmap, rows and columns from -1 to the size are in the border
+        int getBorderedIndex(int row, int col) const { return (row + 1) * (mWidth + 2) + col + 1; }
+        bool isWallBit(int row, int col) const
+        {
+            int bit = getBorderedIndex(row, col);
+            return (mWallBits[bit >> 6] >> (bit & 63)) & 1;
+        }
     };
 }
 
@@ -39,18 +119,85 @@ class Map
 public:
     Map() = delete;
     // Can only be created inside Game::
-    Map(SDL_Renderer* defaultRenderer);
-    ~Map() = default;
+    // Accepts binary (see map_format.h) and text maps
+    // Without a renderer the map works as usual but draws nothing, its tile sheet is never loaded
+    // Compressed maps are streamed unless streaming isn't allowed, then they're decompressed whole
+    Map(SDL_Renderer* defaultRenderer, const std::string& mapPath, bool allowStreaming = true);
+    ~Map();
 
-    // Check wall collisions
+    // Check wall collisions, boxes of any size are checked against every tile under them
     bool checkWallCollisions(const SDL_FRect& box, Vec& adjustPos);
+
+    // Sweeps a box along a displacement, returns true if it hits a wall on the way
+    // Time is the fraction of the displacement travelled before contact, the normal points out of the wall that was hit
+    bool sweepBox(const SDL_FRect& box, const Vec& displacement, float& time, Vec& normal) const;
+
+    // Moves a box along a displacement without passing through walls, sliding along the walls it hits
+    // Returns the displacement actually travelled, contactNormal is set to the sum of the normals of the walls hit
+    Vec slideBox(const SDL_FRect& box, const Vec& displacement, Vec& contactNormal) const;
     
-    // Checks if a point is inside a wall
-    bool isInWall(const Vec& point);
+    // Checks if a point is inside a wall, points outside of the map count as walls
+    bool isInWall(const Vec& point) const;
+
+    // Returns the distance from a point to the nearest wall (or map edge), 0 if the point is inside a wall
+    float getClearance(const Vec& point) const;
+
+    // Signed distance from a point to the nearest wall (or map edge), negative inside walls, read from the distance field in constant time
+    // Streamed maps have no distance field, the tiles around the point are searched instead and points inside walls are at 0
+    float distanceToWall(const Vec& point) const;
+
+    // Direction that leads away from the nearest wall the fastest (unit length), 0 where there's no single direction
+    Vec getWallGradient(const Vec& point) const;
+
+    // Sphere traces a circle along a straight line, returns true if it touches a wall before reaching dest
+    // Time is the fraction of the way to dest where the circle first touches a wall
+    bool traceCircle(const Vec& start, const Vec& dest, float radius, float& time) const;
+
+    // Returns the smallest clearance along a straight line, stops early once it falls below minClearance
+    float getClearance(const Vec& start, const Vec& dest, float minClearance) const;
+
+    // Checks if an agent of the given radius can travel in a straight line between 2 points
+    bool hasLineOfSight(const Vec& start, const Vec& dest, float agentRadius) const;
+
+    // Outlines of the walls, see WallGeometry::traceOutlines (empty for streamed maps)
+    const std::vector<std::vector<Vec>>& getWallOutlines() const { return mWallOutlines; }
+
+    // The walls as a small set of convex shapes (empty for streamed maps)
+    const std::vector<ConvexPolygon>& getWallShapes() const { return mWallShapes; }
+
+    // Returns the minimum vector that moves a shape out of the walls, 0 if it doesn't overlap any
+    Vec resolveWallCollisions(const ConvexPolygon& shape) const;
+
+    // Casts a ray against the wall shapes, returns true if it hits one before reaching dest
+    // Time is the fraction of the way to dest where the ray first enters a wall
+    bool castRay(const Vec& start, const Vec& dest, float& time) const;
 
     // Render all of the tiles in the camera
     void render(const SDL_FRect& pCamera);
 
+    // How the tiles are drawn, each mode falls back to the next one if the renderer doesn't support it
+    enum TileRenderMode
+    {
+        CACHED_TILE_LAYER,  // Pre-drawn textures of whole chunks of tiles (default)
+        BATCHED_TILES,      // All visible tiles in a single draw call
+        TILE_BY_TILE        // A draw call per tile
+    };
+    void setTileRenderMode(TileRenderMode mode);
+
+    // Drops the cached tile layer so it's redrawn from the tiles, needed after tiles change or the renderer's textures are lost
+    void invalidateTileLayer();
+
+    // Streamed maps only, loads the chunks around an area (e.g, the camera or an agent) in the background before they're needed
+    void prefetch(const SDL_FRect& area);
+
+    // Streamed maps only, adds the chunks loaded in the background and evicts old ones, call once per frame
+    void updateStreaming();
+
+    // Streamed maps load tiles while they're read, so they can only be used from the main thread
+    bool isStreamed() const { return mTiles.isStreamed(); }
+
+    int getTileSideLength() const { return TILE_SIDE_LENGTH; }
+
 protected:
     // Initialized in class constructor
     static inline int TILE_SIDE_LENGTH = 0;
@@ -60,22 +207,103 @@ protected:
     static inline float MAP_WIDTH = 0.f;
     static inline float MAP_HEIGHT = 0.f;
 
-    // Used to smoothen wall collisions, merges axis aligned tiles into a single collision box
-    std::vector<SDL_Rect> mergeTiles(const std::vector<const SDL_Rect*>& collidedTiles) const;
+    // Returns the index of the tile that a point lies on, the point must be inside of the map (e.g, one that isInWall rejected isn't)
+    int getTileFromWorldPoint(const Vec& point) const;
+
+    // Counts the point if it's outside of the map, reporting the count at most once per interval instead of on every lookup
+    void countOutOfBoundsLookup(const Vec& point) const;
 
-    // Returns a tile that a point lies on
-    MapInternals::Tile* getTileFromWorldPoint(const Vec& point);
+    // Tile dimensions and position, computed from the tile's index
+    SDL_Rect getTileBox(int index) const;
+    Vec getTileCentre(int index) const;
 
     // Grid of all of the tiles
-    std::vector<std::vector<MapInternals::Tile>> mTiles;
+    MapInternals::TileGrid mTiles;
+
+    // Signed distance field, the distance to the nearest wall from the corners of a grid of cells (row major), negative inside walls
+    // Empty for streamed maps and maps too large for one, their clearance is found by searching the tiles around the point
+    std::vector<float> mDistanceField;
+    int mFieldWidth = 0;        // In samples
+    int mFieldHeight = 0;
+    float mFieldCellSize = 0.f;
+    float mFieldError = 0.f;    // Largest difference between an interpolated distance and the true distance
+
+    // Wall tiles traced into outlines and split into convex shapes, empty for streamed maps
+    std::vector<std::vector<Vec>> mWallOutlines;
+    std::vector<ConvexPolygon> mWallShapes;
+    std::vector<SDL_FRect> mWallShapeBounds;    // Bounding box of each shape, for quick rejection
 
 private:
+    // A block of tiles pre-drawn into a single render target texture
+    struct TileLayerChunk
+    {
+        TexturePtr mTexture;
+        bool mStale = true;
+        Uint64 mLastUsedFrame = 0;
+    };
+
     // Tile texture spritesheet
     Texture mTileTextures;
 
     SDL_Rect mTileSprites[3];
 
+    SDL_Renderer* mRenderer;    // Non-owning pointer
+
+    // Static tile layer, only the chunks near the camera are kept
+    std::unordered_map<int, TileLayerChunk> mTileLayer;
+    TileRenderMode mRenderMode = CACHED_TILE_LAYER;
+    int mTileLayerChunkSideLength = 0;  // In tiles
+    int mTileLayerChunksPerRow = 0;
+    Uint64 mFrame = 0;
+    bool mTileLayerBatchFailed = false;     // Chunks are baked tile by tile until the layer is invalidated
+
+    // Batched tiles, each tile is a quad (4 vertices, 2 triangles)
+    // Rebuilt only when a different range of tiles is drawn, otherwise the quads are just moved
+    SDL_Rect mBatchTiles{ 0, 0, 0, 0 };     // First column and row, and size of the range (in tiles)
+    std::vector<SDL_Rect> mBatchQuads;      // World position and size of each quad
+    std::vector<SDL_Vertex> mBatchVertices;
+    std::vector<int> mBatchIndices;
+    SDL_FPoint mBatchOrigin{ 0.f, 0.f };
+
+    // Out of bounds lookups since the last report, and when it was made
+    mutable std::atomic<Uint32> mOutOfBoundsLookups{ 0 };
+    mutable std::atomic<Uint32> mLastOutOfBoundsReport{ 0 };
+
+    // Binary maps are used in place, the grid points into (or streams from) this mapping
+    MappedFile mMapFile;
+
     bool loadSprites();
-    bool loadMapVariables(std::ifstream& tileMapFile);
+    void setupTileLayer();
+
+    // Draws tiles one by one, origin is the world position drawn at the top left of the render target
+    void drawTiles(int firstRow, int firstCol, int lastRow, int lastCol, float originX, float originY);
+
+    // Draws tiles in a single call, returns false if the renderer can't
+    bool drawTilesBatched(int firstRow, int firstCol, int lastRow, int lastCol, float originX, float originY);
+    void buildTileBatch(const SDL_Rect& tiles);
+
+    // Draws the tile layer chunks overlapping the tiles, returns false if the layer can't be drawn
+    bool drawTileLayer(const SDL_FRect& camera, int firstRow, int firstCol, int lastRow, int lastCol);
+    bool bakeTileLayerChunk(int chunkIndex, TileLayerChunk& chunk);
+    void evictTileLayerChunks();
+    bool loadMap(const std::string& mapPath, bool allowStreaming);
+    bool loadBinaryMap(bool allowStreaming);
+    bool loadTextMap(const std::string& mapPath);
+    void setMapVariables(int tileScale, int mapWidthInTiles, int mapHeightInTiles);
+
+    // Measures the distance to the nearest wall at every sample of the distance field
+    void buildDistanceField();
+
+    // Euclidean distance transform, replaces every sample with the squared distance (in cells) to the nearest sample that's 0
+    void transformDistances(std::vector<float>& distances) const;
+
+    // Traces the wall tiles into outlines and convex shapes
+    void buildWallShapes();
+
+    // Returns the distance between a point and the closest point of a tile
+    float getDistanceToTile(const Vec& point, int tileIndex) const;
+
+    // Returns the distance from a point to the closest wall within a few tiles, or a lower bound if there's none that close
+    float getNearbyWallDistance(const Vec& point, int row, int col) const;
 };
 
@@ -0,0 +1,91 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+namespace MapInternals
+{
+    enum tileType : std::uint8_t { MISC_TILE, FLOOR_TILE, WALL_TILE, TOTAL_TILE_TYPES };
+}
+
+// Binary tile map format, all values are little endian
+//
+// Packed maps can be memory mapped and used in place:
+// [Header][Tile types: 1 byte per tile, row major][Padding to 8 bytes][Wall bitmap: 1 bit per tile, 64 bit words]
+// The wall bitmap covers the grid with a 1 tile border of walls around it, so lookups just outside of the map land on a wall
+//
+// Chunk compressed maps split the grid into square chunks and run length encode each one, so chunks can be streamed in independently:
+// [Header][Chunk offsets: (chunk count + 1) 32 bit offsets from the start of the file][Chunks: (run length, tile type) byte pairs]
+namespace MapFormat
+{
+    constexpr char MAGIC[4] = { 'S', 'P', 'K', 'M' };
+    constexpr std::uint32_t VERSION = 2;
+
+    // Header flags
+    constexpr std::uint32_t FLAG_CHUNK_COMPRESSED = 1 << 0;
+
+    // Chunk dimensions (in tiles) used by the converter
+    constexpr std::uint32_t DEFAULT_CHUNK_SIDE_LENGTH = 32;
+
+    struct Header
+    {
+        char mMagic[4];
+        std::uint32_t mVersion;
+        std::uint32_t mTileSideLength;
+        std::uint32_t mWidthInTiles;
+        std::uint32_t mHeightInTiles;
+        std::uint32_t mFlags;
+        std::uint32_t mChunkSideLength;    // 0 for packed maps
+        std::uint32_t mReserved;
+    };
+    static_assert(sizeof(Header) == 32, "Map header must not be padded");
+
+    // A map held entirely in memory, used when converting between formats
+    struct MapData
+    {
+        int mTileSideLength = 0;
+        int mWidthInTiles = 0;
+        int mHeightInTiles = 0;
+
+        // Tile types in row major order
+        std::vector<std::uint8_t> mTiles;
+    };
+
+    // Reads the original text format (a short header followed by whitespace separated tile types)
+    bool readTextMap(const std::string& path, MapData& map);
+
+    // Writes a binary map, optionally chunk compressed
+    bool writeBinaryMap(const std::string& path, const MapData& map, bool compress);
+
+    // Returns the header of a binary map held in memory, nullptr if the data isn't a valid binary map of this version
+    const Header* getHeader(const std::uint8_t* data, std::size_t size);
+
+    // Layout of packed maps, in bytes from the start of the file
+    std::size_t getTilesOffset();
+    std::size_t getWallBitsOffset(const Header& header);
+    std::size_t getPackedFileSize(const Header& header);
+
+    // Number of 64 bit words needed to hold 1 bit per tile
+    std::size_t getWallBitsWordCount(std::size_t tileCount);
+
+    // Number of tiles in a grid with a 1 tile border around it, the size of a wall bitmap
+    std::size_t getBorderedTileCount(std::size_t widthInTiles, std::size_t heightInTiles);
+
+    // Fills in a wall bitmap (getWallBitsWordCount(getBorderedTileCount()) words) from row major tile types, the border is all walls
+    void buildWallBits(const std::uint8_t* tiles, std::size_t widthInTiles, std::size_t heightInTiles, std::uint64_t* wallBits);
+
+    // Checks every tile type of a packed map is valid and the wall bitmap marks exactly the wall tiles and the border
+    bool checkPackedTiles(const std::uint8_t* data, const Header& header);
+
+    // Number of chunks across and down a compressed map
+    int getChunksPerRow(const Header& header);
+    int getChunksPerColumn(const Header& header);
+
+    // Decodes a single chunk of a compressed map, rows of the chunk are written stride bytes apart
+    bool decompressChunk(const std::uint8_t* data, std::size_t size, std::size_t chunkIndex, std::uint8_t* tiles, std::size_t stride);
+
+    // Decodes every chunk of a compressed map into a row major tile array (width * height bytes)
+    bool decompressTiles(const std::uint8_t* data, std::size_t size, std::uint8_t* tiles);
+}
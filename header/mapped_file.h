@@ -0,0 +1,36 @@
+#pragma once
+#include <SDL.h>
+
+#include <cstddef>
+#include <string>
+
+
+// Maps a whole file into memory (read only file, copy-on-write pages)
+// Writes through the mapping stay private to the process and never reach the file
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	~MappedFile();
+
+	// Returns false if the file can't be opened or is empty
+	bool open(const std::string& path);
+	void close();
+
+	bool isOpen() const;
+
+	Uint8* getData() const;
+	std::size_t getSize() const;
+
+private:
+	Uint8* mData = nullptr;
+	std::size_t mSize = 0;
+
+#ifdef _WIN32
+	// Windows handles, kept as void* to avoid including windows.h in the header
+	void* mFile = nullptr;
+	void* mMapping = nullptr;
+#endif
+};
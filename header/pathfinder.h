@@ -9,9 +9,20 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <functional>
+#include <string>
 
 
-// Node's used by the route graph
+// A connection to an accessible route node
+struct GraphEdge
+{
+    // The route node (tile index) at the end of the edge
+    int mNode;
+
+    // The smallest distance between the edge and a wall, agents with a larger radius can't use the edge
+    float mClearance;
+};
+
+// A route node's state during a single search
 struct NodeInfo
 {
     NodeInfo();
@@ -20,7 +31,7 @@ struct NodeInfo
     void reset();
 
     // Returns the sum of g-cost and h-cost
-    int getFcost();
+    int getFcost() const;
 
     // Distance from the start
     int mGcost;
@@ -28,11 +39,19 @@ struct NodeInfo
     // Distance from the end
     int mHcost;
 
-    // The predecessor node
-    MapInternals::Tile* mParent;
+    // The predecessor node, -1 if there is none
+    int mParent;
+};
+
+// The working memory of one A* search
+// Kept apart from the graphs so several threads can search at once
+struct PathSearch
+{
+    // Nodes the search has reached, untouched nodes are never read
+    std::unordered_map<int, NodeInfo> mNodes;
 
-    // A list of all of the accessible route nodes from this node
-    std::vector<MapInternals::Tile*> mNeighbours;
+    std::vector<int> mOpenSet;
+    std::unordered_set<int> mClosedSet;
 };
 
 class Pathfinder: public Map
@@ -40,48 +59,56 @@ class Pathfinder: public Map
 public:
     Pathfinder() = delete;
     // Can only be created inside Game::
-    Pathfinder(SDL_Renderer* defaultRenderer);
+    // The graphs connect nodes across the whole map, so the map is never streamed, compressed maps are decompressed whole
+    Pathfinder(SDL_Renderer* defaultRenderer, const std::string& mapPath);
     ~Pathfinder();
 
-    // Creates a sequence of tile's connecting 2 points
-    bool findPath(const Vec& start, const Vec& end, std::stack<SDL_Point>& path);
+    // Creates a sequence of tile's connecting 2 points, only using edges wide enough for the agent
+    // Doesn't modify the graphs, so it's safe to call from several threads at once
+    bool findPath(const Vec& start, const Vec& end, std::stack<SDL_Point>& path, float agentRadius = MIN_AGENT_RADIUS) const;
+
+    // The smallest agent the graphs are built for, all edges have atleast this much clearance
+    static constexpr float MIN_AGENT_RADIUS = 20.f;
 
 private:
     // Check if 2 points are accessible to each other in a straight path
-    bool isAccessible(const MapInternals::Tile* start, const MapInternals::Tile* dest);
-    bool isAccessible(const SDL_FRect& entity, const MapInternals::Tile* destTile);
-    bool isAccessible(const SDL_FRect& startEntity, const SDL_FRect& destEntity);
-    bool isAccessible(const Vec& startPoint, const Vec& endPoint);
+    bool isAccessible(int startTile, int destTile, float agentRadius) const;
+    bool isAccessible(const SDL_FRect& entity, int destTile, float agentRadius) const;
+    bool isAccessible(const SDL_FRect& startEntity, const SDL_FRect& destEntity, float agentRadius) const;
+    bool isAccessible(const Vec& startPoint, const Vec& endPoint, float agentRadius) const;
+
+    // Returns the clearance of the straight path between 2 tiles' centres, or less than MIN_AGENT_RADIUS if it's too narrow
+    float getEdgeClearance(int startTile, int destTile) const;
 
     // Build pathfinding graphs
     void buildRouteGraph();
+    // Returns the route nodes' tiles in ascending order
+    std::vector<int> getRouteNodes() const;
     void connectRouteGraph();
     void buildRampGraph();
     void connectRampGraph();
 
-    float getDistance(const Vec& startPoint, const MapInternals::Tile* endTile) const;
+    float getDistance(const Vec& startPoint, int endTile) const;
 
     // Returns the manhattan distance between 2 tiles
-    int getDistance(const MapInternals::Tile* startTile, const MapInternals::Tile* endTile) const;
+    int getDistance(int startTile, int endTile) const;
 
     // Used by A* to keep the open set (heap) sorted
     // Determines which node has the better potential to find the destination node
-    bool higherPotential(MapInternals::Tile* op2, MapInternals::Tile* op1);
+    static bool higherPotential(const NodeInfo& op2, const NodeInfo& op1);
     // Used to sort the list of neighbors of a ramp node by proximity
-    bool closerNode(MapInternals::Tile* startTile, MapInternals::Tile* op2, MapInternals::Tile* op1);
+    bool closerNode(int startTile, int op2, int op1);
 
     // Uses a ramp node to start pathfinding
-    void useRamp(std::vector<MapInternals::Tile*>& openSet, std::unordered_set<MapInternals::Tile*>& closedSet, MapInternals::Tile* firstTile, MapInternals::Tile* lastTile);
+    void useRamp(PathSearch& search, int firstTile, int lastTile, float agentRadius) const;
 
     // Backtracks a path in the route graph and converts in into a vector of points
-    void createPath(MapInternals::Tile* end, std::stack<SDL_Point>& path) const;
-
-    std::function<bool(MapInternals::Tile*, MapInternals::Tile*)> heapComp;
+    void createPath(const PathSearch& search, int end, std::stack<SDL_Point>& path) const;
 
     // Holds a neighbour list of accessible route nodes for every tile on the map (except for walls and the route nodes themselves)
-    std::unordered_map<MapInternals::Tile*, std::vector<MapInternals::Tile*>> mRampGraph;
+    std::unordered_map<int, std::vector<GraphEdge>> mRampGraph;
 
-    // Stores the map's important tiles that allow for navigation of the entire map
-    std::unordered_map<MapInternals::Tile*, NodeInfo> mRouteGraph;
+    // Stores the map's important tiles that allow for navigation of the entire map, and the accessible route nodes from each one
+    std::unordered_map<int, std::vector<GraphEdge>> mRouteGraph;
 };
 
@@ -92,6 +92,9 @@ public:
 	// Returns minimuim vector to resolve all collisions
 	static Vec resolveCollisions(const ConvexPolygon& moveableShape, const std::vector<ConvexPolygon>& fixedShapes);
 
+	// Adds a single collision solution to the total, solutions can be added one at a time as they're found
+	static void addToSolution(const Vec& solution, Vec& totalSolution);
+
 private:
 	// Used by ctor to check if the polygon is convex, also checks for collinear edges, self intersections, and a clockwise winding order
 	bool isConvex();
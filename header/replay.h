@@ -0,0 +1,101 @@
+#pragma once
+#include "world.h"
+
+#include <SDL.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+// Binary input replay format, all values are little endian
+//
+// [Header][Events: in the order they were recorded][State hashes: one 64 bit hash of the world after each tick]
+namespace ReplayFormat
+{
+    constexpr char MAGIC[4] = { 'S', 'P', 'K', 'R' };
+    constexpr std::uint32_t VERSION = 1;
+
+    struct Header
+    {
+        char mMagic[4];
+        std::uint32_t mVersion;
+        float mTickLength;            // In seconds, replays run at the tick rate they were recorded at
+        std::uint32_t mTickCount;
+        std::uint32_t mEventCount;
+        std::uint32_t mReserved;
+    };
+    static_assert(sizeof(Header) == 24, "Replay header must not be padded");
+
+    // A key press or release, applied just before its tick runs
+    struct Event
+    {
+        std::uint32_t mTick;
+        std::uint32_t mType;          // SDL_KEYDOWN or SDL_KEYUP
+        std::int32_t mKey;            // SDL_Keycode
+    };
+    static_assert(sizeof(Event) == 12, "Replay events must not be padded");
+
+    // Hash of every MechanicalComponent's position and velocity, two worlds with the same hash have (almost certainly) moved the same way
+    std::uint64_t hashWorld(World& world);
+}
+
+// Records the input the simulation sees, tick by tick, along with a hash of the world after every tick
+class InputRecorder
+{
+public:
+    InputRecorder() = delete;
+    // Nothing is written until save
+    explicit InputRecorder(const std::string& path);
+
+    // Only input that steers entities is recorded, key presses that aren't repeats
+    static bool isRecorded(const SDL_Event& event);
+
+    // Records an event that arrived before the tick
+    void recordEvent(const SDL_Event& event, int tick);
+    // Records the hash of the world once a tick has run
+    void recordTick(std::uint64_t stateHash);
+
+    bool save(float tickLength) const;
+
+private:
+    std::string mPath;
+    std::vector<ReplayFormat::Event> mEvents;
+    std::vector<std::uint64_t> mHashes;
+};
+
+// Feeds recorded input back tick by tick, and checks the world ends each tick the way it did when it was recorded
+class InputReplay
+{
+public:
+    bool load(const std::string& path);
+
+    // Calls function(const SDL_Event&) for every event recorded before the tick, ticks must be asked for in order
+    template<typename Function>
+    void forEachEvent(int tick, Function&& function)
+    {
+        for (; mNextEvent < mEvents.size() && mEvents[mNextEvent].mTick <= static_cast<std::uint32_t>(tick); ++mNextEvent)
+            function(toSdlEvent(mEvents[mNextEvent]));
+    }
+
+    // Compares the world's hash after the tick with the recorded one, returns false if they differ
+    // Only the first tick that differs is remembered, everything after it follows from it
+    bool checkTick(int tick, std::uint64_t stateHash);
+
+    int getTickCount() const { return static_cast<int>(mHashes.size()); }
+    float getTickLength() const { return mTickLength; }
+
+    // -1 until a tick's hash doesn't match
+    int getDivergedTick() const { return mDivergedTick; }
+
+private:
+    float mTickLength = 0.f;
+    std::vector<ReplayFormat::Event> mEvents;
+    std::vector<std::uint64_t> mHashes;
+
+    std::size_t mNextEvent = 0;
+    int mDivergedTick = -1;
+
+    static SDL_Event toSdlEvent(const ReplayFormat::Event& event);
+};
@@ -0,0 +1,130 @@
+#pragma once
+#include "vec.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+
+// Binary world snapshot format, see World::saveSnapshot, all values are little endian
+//
+// [Header][Archetypes: one for each archetype with entities in it]
+// Archetype: [Component mask: 64 bits][Entity count][Saved column count][Entity handles][Columns]
+// Column: [Type id][Size in bytes][Each entity's component state, in entity order]
+//
+// Component type ids are handed out as types are first seen, so snapshots are only read by the build that wrote them
+namespace SnapshotFormat
+{
+    constexpr char MAGIC[4] = { 'S', 'P', 'K', 'S' };
+    constexpr std::uint32_t VERSION = 1;
+
+    struct Header
+    {
+        char mMagic[4];
+        std::uint32_t mVersion;
+        std::uint32_t mEntityCount;
+        std::uint32_t mArchetypeCount;
+    };
+    static_assert(sizeof(Header) == 16, "Snapshot header must not be padded");
+}
+
+// Appends plain values to a snapshot
+// Writing into the same buffer every time means it's only allocated once it's as big as a snapshot gets
+class SnapshotWriter
+{
+public:
+    SnapshotWriter() = delete;
+    explicit SnapshotWriter(std::vector<std::uint8_t>& buffer) : mBuffer{ &buffer } {}
+
+    template<typename T>
+    void write(const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be written to snapshots");
+        writeBytes(&value, sizeof(T));
+    }
+
+    // Vec has its own copy assignment, so it's written as its two floats
+    void write(const Vec& vec)
+    {
+        write(vec.getX());
+        write(vec.getY());
+    }
+
+    void writeBytes(const void* data, std::size_t size)
+    {
+        std::size_t offset = mBuffer->size();
+        mBuffer->resize(offset + size);
+        std::memcpy(mBuffer->data() + offset, data, size);
+    }
+
+    // Where the next value will be written, so a size can be filled in once what it's the size of has been written
+    std::size_t getOffset() const { return mBuffer->size(); }
+
+    template<typename T>
+    void writeAt(std::size_t offset, const T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be written to snapshots");
+        std::memcpy(mBuffer->data() + offset, &value, sizeof(T));
+    }
+
+private:
+    std::vector<std::uint8_t>* mBuffer;
+};
+
+// Reads values straight out of a snapshot, the snapshot isn't copied first so it can be e.g. a memory mapped file
+// Reading past the end reads nothing and marks the reader as failed
+class SnapshotReader
+{
+public:
+    SnapshotReader() = delete;
+    SnapshotReader(const std::uint8_t* data, std::size_t size) : mData{ data }, mSize{ size } {}
+
+    // Returns false and leaves the value alone if the snapshot doesn't have enough bytes left
+    template<typename T>
+    bool read(T& value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain values can be read from snapshots");
+        const std::uint8_t* bytes = readBytes(sizeof(T));
+        if (bytes == nullptr)
+            return false;
+
+        std::memcpy(&value, bytes, sizeof(T));
+        return true;
+    }
+
+    bool read(Vec& vec)
+    {
+        float x;
+        float y;
+        if (!read(x) || !read(y))
+            return false;
+
+        vec = Vec{ x, y };
+        return true;
+    }
+
+    // Returns a pointer into the snapshot and moves past the bytes, nullptr if there aren't that many left
+    const std::uint8_t* readBytes(std::size_t size)
+    {
+        if (mFailed || size > mSize - mOffset)
+        {
+            mFailed = true;
+            return nullptr;
+        }
+
+        const std::uint8_t* bytes = mData + mOffset;
+        mOffset += size;
+        return bytes;
+    }
+
+    std::size_t getRemaining() const { return mSize - mOffset; }
+    bool hasFailed() const { return mFailed; }
+
+private:
+    const std::uint8_t* mData;
+    std::size_t mSize;
+    std::size_t mOffset = 0;
+    bool mFailed = false;
+};
@@ -0,0 +1,146 @@
+#pragma once
+#include "world.h"
+#include "vec.h"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+
+// Finds the entities near a point or in an area without checking every entity
+// Entities with a MechanicalComponent are hashed into square cells by the centre of their collision box
+// Queries don't allocate, and see the entities as they were at the last rebuild
+class SpatialGrid
+{
+public:
+    SpatialGrid() = delete;
+    // Cells are cellSize on each side, e.g. the map's tile size
+    explicit SpatialGrid(float cellSize);
+
+    // Re-reads every MechanicalComponent's collision box, call once per update after entities have moved
+    void rebuild(World& world);
+
+    // An entity as of the last rebuild
+    struct Entry
+    {
+        EntityHandle mHandle;
+        SDL_FRect mBox;
+        Vec mCentre;
+        int mCellX;
+        int mCellY;
+    };
+
+    // A result of findNearest
+    struct Neighbour
+    {
+        EntityHandle mHandle;
+        Vec mCentre;        // Of the neighbour's box
+        float mDistance;    // Between box centres
+    };
+
+    // Calls function(const Entry&) for every entity whose box touches the circle
+    template<typename Function>
+    void forEachInRadius(const Vec& centre, float radius, Function&& function) const
+    {
+        float radiusSquared = radius * radius;
+        forEachInCells(getCell(centre.getX() - radius - mMaxHalfWidth), getCell(centre.getY() - radius - mMaxHalfHeight),
+            getCell(centre.getX() + radius + mMaxHalfWidth), getCell(centre.getY() + radius + mMaxHalfHeight), [&](const Entry& entry)
+            {
+                // Distance from the centre to the closest point on the box
+                float gapX = std::max({ entry.mBox.x - centre.getX(), 0.f, centre.getX() - (entry.mBox.x + entry.mBox.w) });
+                float gapY = std::max({ entry.mBox.y - centre.getY(), 0.f, centre.getY() - (entry.mBox.y + entry.mBox.h) });
+                if (gapX * gapX + gapY * gapY <= radiusSquared)
+                    function(entry);
+            });
+    }
+
+    // Calls function(const Entry&) for every entity whose box overlaps the area
+    template<typename Function>
+    void forEachInBox(const SDL_FRect& area, Function&& function) const
+    {
+        forEachInCells(getCell(area.x - mMaxHalfWidth), getCell(area.y - mMaxHalfHeight),
+            getCell(area.x + area.w + mMaxHalfWidth), getCell(area.y + area.h + mMaxHalfHeight), [&](const Entry& entry)
+            {
+                if (entry.mBox.x <= area.x + area.w && area.x <= entry.mBox.x + entry.mBox.w && entry.mBox.y <= area.y + area.h && area.y <= entry.mBox.y + entry.mBox.h)
+                    function(entry);
+            });
+    }
+
+    // Write the handles of up to maxResults entities to results
+    // Return how many entities matched, which is more than maxResults if some didn't fit
+    int queryRadius(const Vec& centre, float radius, EntityHandle* results, int maxResults) const;
+    int queryBox(const SDL_FRect& area, EntityHandle* results, int maxResults) const;
+
+    // Finds up to k entities closest to the point, closest first, results must have room for k
+    // Entities further than maxDistance and the excluded entity are skipped, returns how many were found
+    int findNearest(const Vec& point, int k, Neighbour* results, float maxDistance = std::numeric_limits<float>::infinity(), EntityHandle exclude = EntityHandle{}) const;
+
+    int getEntityCount() const { return static_cast<int>(mEntries.size()); }
+    float getCellSize() const { return mCellSize; }
+
+private:
+    float mCellSize;
+    float mInverseCellSize;
+
+    // Entries sorted by bucket, bucket i is mEntries[mBucketStarts[i]] up to mEntries[mBucketStarts[i + 1]]
+    // Several cells can share a bucket, entries remember their cell so they're only seen from their own
+    std::vector<Entry> mEntries;
+    std::vector<int> mBucketStarts;
+    Uint32 mBucketMask = 0;
+
+    // Reused by every rebuild
+    std::vector<Entry> mUnsorted;
+    std::vector<Uint32> mUnsortedBuckets;
+
+    // The largest box half sizes, queries look this much further so boxes that reach in from another cell are found
+    float mMaxHalfWidth = 0.f;
+    float mMaxHalfHeight = 0.f;
+
+    // The cells with entities in them, queries never look past these
+    int mFirstCellX = 0;
+    int mFirstCellY = 0;
+    int mLastCellX = -1;
+    int mLastCellY = -1;
+
+    // Coordinates are clamped so far away points don't overflow, they end up past the occupied cells anyway
+    int getCell(float coordinate) const
+    {
+        return static_cast<int>(std::clamp(std::floor(coordinate * mInverseCellSize), -1e9f, 1e9f));
+    }
+
+    Uint32 getBucket(int cellX, int cellY) const
+    {
+        return ((static_cast<Uint32>(cellX) * 73856093u) ^ (static_cast<Uint32>(cellY) * 19349663u)) & mBucketMask;
+    }
+
+    // Calls function(const Entry&) for every entry in a range of cells
+    template<typename Function>
+    void forEachInCells(int firstX, int firstY, int lastX, int lastY, Function&& function) const
+    {
+        firstX = std::max(firstX, mFirstCellX);
+        firstY = std::max(firstY, mFirstCellY);
+        lastX = std::min(lastX, mLastCellX);
+        lastY = std::min(lastY, mLastCellY);
+
+        for (int iCellY = firstY; iCellY <= lastY; ++iCellY)
+        {
+            for (int iCellX = firstX; iCellX <= lastX; ++iCellX)
+                forEachInCell(iCellX, iCellY, function);
+        }
+    }
+
+    template<typename Function>
+    void forEachInCell(int cellX, int cellY, Function&& function) const
+    {
+        Uint32 bucket = getBucket(cellX, cellY);
+        for (int iEntry = mBucketStarts[bucket]; iEntry < mBucketStarts[bucket + 1]; ++iEntry)
+        {
+            const Entry& entry = mEntries[iEntry];
+            if (entry.mCellX == cellX && entry.mCellY == cellY)
+                function(entry);
+        }
+    }
+};
@@ -0,0 +1,33 @@
+#pragma once
+#include "vec.h"
+#include "spatial_grid.h"
+#include "world.h"
+
+
+// Steering maths shared by the components that move entities
+namespace Steering
+{
+    // fastPow stays within this fraction of powf, for positive bases and results that fit in a float
+    constexpr float FAST_POW_MAX_ERROR = 1e-5f;
+
+    // getSeparation only looks at this many neighbours, so it costs the same however big the crowd is
+    constexpr int SEPARATION_NEIGHBOURS = 6;
+
+    // Unit vector along a displacement, worked out without trig
+    // The zero vector gives (1, 0), the direction atan2f(0, 0) gives
+    Vec getDirection(const Vec& displacement);
+
+    // Drag against a velocity, its magnitude is speed ^ exponent up to the cap, 0 if the velocity is
+    // Uses powf, it's the reference addDrag is checked against
+    Vec getDrag(const Vec& vel, float exponent, float cap);
+
+    // Approximates powf as 2 ^ (exponent * log2(base)) with polynomials, base must be positive
+    float fastPow(float base, float exponent);
+
+    // Adds the drag of count velocities to their accelerations, 4 at a time with fastPow
+    void addDrag(const float* velX, const float* velY, const float* dragExponent, const float* dragCap, float* accelX, float* accelY, int count);
+
+    // Direction away from the closest entities in the grid within the radius, each pushing harder the closer it is
+    // Its length is up to 1, the entity itself is skipped
+    Vec getSeparation(const SpatialGrid& grid, const Vec& centre, float radius, EntityHandle self);
+}
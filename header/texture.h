@@ -7,11 +7,13 @@
 #include <string>
 
 
+// Textures are loaded the first time they're drawn or measured, and never if there's no renderer (see Game's headless mode)
 class Texture
 {
 public:
 	Texture() = delete;
 	// Can only be created inside Game::
+	// The font and renderer must outlive the texture, the text is only rendered once it's needed
 	Texture(SDL_Renderer* defaultRenderer, std::string pathOrText, TTF_Font* defaultFont = nullptr, SDL_Color* textColor = nullptr);
 	Texture(Texture&& other) noexcept;
 
@@ -35,17 +37,29 @@ public:
 	// Renders texture at given point
 	bool draw(int x, int y, const SDL_Rect* clip = nullptr, double angle = 0.0, SDL_Point* center = nullptr, SDL_RendererFlip flip = SDL_FLIP_NONE);
 
-	// Gets texture dimensions
+	// Renders textured triangles in a single call, texture coordinates are normalized (0 to 1)
+	bool drawGeometry(const SDL_Vertex* vertices, int vertexCount, const int* indices, int indexCount);
+
+	// Gets texture dimensions, 0 without a renderer
 	int getWidth() const;
 	int getHeight() const;
 
 private:
-	// Texture owned by this class
-	TexturePtr mTexture;
+	// Texture owned by this class, loaded on first use
+	mutable TexturePtr mTexture;
 
 	// Texture dimensions
-	int mWidth;
-	int mHeight;
+	mutable int mWidth = 0;
+	mutable int mHeight = 0;
+
+	// What the texture is loaded from, a path, or text if there's a font
+	std::string mSource;
+	SDL_Color mTextColor{ 0, 0, 0, 0 };
+	mutable bool mLoaded = false;
+
+	// Loads the texture if it hasn't been yet, returns false if there's no renderer to load it with
+	bool ensureLoaded() const;
+	bool loadSource() const;
 
 	// Required for loading and drawing textures
 	// These objects are not owned by Texture
@@ -29,19 +29,31 @@ using RendererPtr = StatelessUniquePtrInternals::StatelessUniquePtr<SDL_Renderer
 using WindowPtr = StatelessUniquePtrInternals::StatelessUniquePtr<SDL_Window, SDL_DestroyWindow>;
 
 // This template class generates a unique id for every type(s) using it
-// The class' name (char*) is resolved at compile time
-// Static types are used to avoid creating the class
+// Ids are dense, counting up from 0 in the order types are first seen, so they can index arrays
+// They're assigned during static initialization, no RTTI is needed
 
-using typeID = const void*;
+using typeID = int;
+
+namespace IdGenInternals
+{
+    inline typeID nextTypeID()
+    {
+        static typeID next = 0;
+        return next++;
+    }
+}
 
 template <typename... Arguments>
 struct IdGen {
     IdGen() = delete;
 
-    static constexpr inline typeID getTypeID()
+    static inline typeID getTypeID()
     {
-        return reinterpret_cast<typeID>(typeid(IdGen<Arguments...>).name());
+        return mId;
     }
+
+private:
+    static inline const typeID mId = IdGenInternals::nextTypeID();
 };
 
 // A wrapper class that gives circular behvior to vectors
@@ -26,15 +26,15 @@ public:
     Vec(float x, float y) : mX{ x }, mY{ y }{}
     ~Vec() = default;
 
-    // Getters
+    // Getters, inline since they're used in every update
     float operator[](int row) const;
-    float getX() const;
-    float getY() const;
+    float getX() const { return mX; }
+    float getY() const { return mY; }
     bool isZeroVector() const;
 
     // Setters
-    void setX(float xValue);
-    void setY(float yValue);
+    void setX(float xValue) { mX = xValue; }
+    void setY(float yValue) { mY = yValue; }
 
     // Vector by vector operations
     float cross(const Vec& vec2) const;       // 2d cross product (determinant)
@@ -0,0 +1,19 @@
+#pragma once
+#include "map.h"
+#include "polygon.h"
+#include "vec.h"
+
+#include <vector>
+
+
+// Turns the wall tiles of a map into polygon geometry, so walls can be collided with as a few large shapes instead of one box per tile
+namespace WallGeometry
+{
+    // Traces the edges between wall and non-wall tiles into closed outlines, with a vertex only where the outline turns
+    // Outlines around walls are clockwise (see Polygon::isClockwise), outlines around areas enclosed by walls are counterclockwise
+    // Walls that only touch at a corner get separate outlines
+    std::vector<std::vector<Vec>> traceOutlines(const MapInternals::TileGrid& tiles, int tileSideLength);
+
+    // Splits the area inside the outlines into rectangles, rectangles that share a side of the same length are merged
+    std::vector<ConvexPolygon> decompose(const std::vector<std::vector<Vec>>& outlines);
+}
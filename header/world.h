@@ -0,0 +1,535 @@
+#pragma once
+#include "components/component.h"
+#include "job_system.h"
+#include "snapshot.h"
+#include "util.h"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+class Entity;
+
+namespace WorldInternals
+{
+	// Component type ids index fixed size arrays and bitmasks, see IdGen
+	constexpr int MAX_COMPONENT_TYPES = 64;
+	using ComponentMask = Uint64;
+
+	// Components are allocated this many at a time
+	constexpr int COMPONENTS_PER_BLOCK = 64;
+
+	// Entities are allocated this many at a time
+	constexpr int ENTITIES_PER_SLAB = 256;
+
+	// Entity handles pack the entity's id in the low bits and its generation in the rest
+	constexpr int ENTITY_ID_BITS = 20;
+	constexpr Uint32 ENTITY_ID_MASK = (Uint32{ 1 } << ENTITY_ID_BITS) - 1;
+	constexpr Uint32 ENTITY_GENERATION_COUNT = Uint32{ 1 } << (32 - ENTITY_ID_BITS);
+
+	// Compact once this much of the entity slabs is unused, at most once every so many updates so waves of entities can reuse the memory
+	constexpr float COMPACT_FRAGMENTATION = 0.75f;
+	constexpr int COMPACT_INTERVAL_UPDATES = 600;
+
+	// Components of the same type are updated this many at a time by a worker thread
+	constexpr int ROWS_PER_JOB = 16;
+
+	// Types past the limit can't be added, so no archetype matches their mask
+	template<typename T>
+	ComponentMask maskOf() { return IdGen<T>::getTypeID() < MAX_COMPONENT_TYPES ? ComponentMask{ 1 } << IdGen<T>::getTypeID() : ~ComponentMask{ 0 }; }
+}
+
+// The update phases, every entity finishes a phase before any starts the next one
+enum UpdatePhase
+{
+	UPDATE_1,	// Steering
+	INTEGRATE,	// Movement, run by types with a static integrate function over whole runs of components, see MechanicalComponent::integrate
+	UPDATE_2,	// Map collision
+	UPDATE_3,	// Camera, and reading other entities' final positions
+	UPDATE_PHASE_COUNT
+};
+
+// State shared between entities, see World::setMainThreadResources
+enum SharedResource : Uint32
+{
+	SHARED_MAP = 1 << 0
+};
+
+// What a component type touches while it runs a phase, so the world knows which updates can run at the same time
+// Types declare it with: static void declareAccess(UpdatePhase phase, SystemAccess& access)
+// Types that don't declare access run every phase they update in alone, on the calling thread
+struct SystemAccess
+{
+	bool mRuns = false;									// The type does something in the phase
+	bool mMainThread = false;							// Must run on the calling thread, e.g. it calls SDL
+	WorldInternals::ComponentMask mReads = 0;			// Components of the same entity
+	WorldInternals::ComponentMask mWrites = 0;			// Components of the same entity, the type's own component is always included
+	WorldInternals::ComponentMask mReadsOthers = 0;		// Components of other entities
+	Uint32 mResources = 0;								// SharedResource flags
+
+	SystemAccess& runs() { mRuns = true; return *this; }
+	SystemAccess& onMainThread() { mMainThread = mRuns = true; return *this; }
+	SystemAccess& uses(SharedResource resource) { mResources |= resource; mRuns = true; return *this; }
+
+	template<typename T> SystemAccess& reads() { mReads |= WorldInternals::maskOf<T>(); mRuns = true; return *this; }
+	template<typename T> SystemAccess& writes() { mWrites |= WorldInternals::maskOf<T>(); mRuns = true; return *this; }
+	template<typename T> SystemAccess& readsOthers() { mReadsOthers |= WorldInternals::maskOf<T>(); mRuns = true; return *this; }
+};
+
+namespace WorldInternals
+{
+	// How to handle a component type once it's stored without its type
+	struct ComponentType
+	{
+		typeID mId;
+		std::size_t mSize;
+		std::size_t mAlign;
+		void (*mMoveConstruct)(void* dest, void* source);
+		void (*mDestroy)(void* component);
+		Component* (*mAsComponent)(void* component);
+
+		// Updates count components stored back to back, by phase, nullptr if the type has nothing to run in the phase
+		void (*mUpdateRows[UPDATE_PHASE_COUNT])(void* first, int count, float deltaTime);
+
+		// Saves and restores the state of count components stored back to back, nullptr if the type has no saveState and loadState
+		// Check reads the state of count components without restoring it, returns false if it's corrupt
+		void (*mSaveRows)(const void* first, int count, SnapshotWriter& writer);
+		void (*mLoadRows)(void* first, int count, SnapshotReader& reader);
+		bool (*mCheckRows)(int count, SnapshotReader& reader);
+
+		bool mDeclaresAccess;
+		SystemAccess mAccess[UPDATE_PHASE_COUNT];
+	};
+
+	template<typename T>
+	ComponentType makeComponentType()
+	{
+		// Everything a type doesn't have is left null
+		ComponentType type{};
+		type.mId = IdGen<T>::getTypeID();
+		type.mSize = sizeof(T);
+		type.mAlign = alignof(T);
+		type.mMoveConstruct = [](void* dest, void* source) { new (dest) T(std::move(*static_cast<T*>(source))); };
+		type.mDestroy = [](void* component) { static_cast<T*>(component)->~T(); };
+		type.mAsComponent = [](void* component) -> Component* { return static_cast<T*>(component); };
+
+		type.mUpdateRows[UPDATE_1] = [](void* first, int count, float deltaTime) { for (int i = 0; i < count; ++i) static_cast<T*>(first)[i].update1(deltaTime); };
+		type.mUpdateRows[UPDATE_2] = [](void* first, int count, float deltaTime) { for (int i = 0; i < count; ++i) static_cast<T*>(first)[i].update2(deltaTime); };
+		type.mUpdateRows[UPDATE_3] = [](void* first, int count, float deltaTime) { for (int i = 0; i < count; ++i) static_cast<T*>(first)[i].update3(deltaTime); };
+
+		if constexpr (requires(T* rows) { T::integrate(rows, 0, 0.f); })
+			type.mUpdateRows[INTEGRATE] = [](void* first, int count, float deltaTime) { T::integrate(static_cast<T*>(first), count, deltaTime); };
+
+		// Types with state worth keeping declare: void saveState(SnapshotWriter&) const, void loadState(SnapshotReader&)
+		// and static bool checkState(SnapshotReader&), which reads past one component's state and returns false if it's corrupt
+		if constexpr (requires(T& component, SnapshotWriter& writer, SnapshotReader& reader) { std::as_const(component).saveState(writer); component.loadState(reader); { T::checkState(reader) } -> std::same_as<bool>; })
+		{
+			type.mSaveRows = [](const void* first, int count, SnapshotWriter& writer) { for (int i = 0; i < count; ++i) static_cast<const T*>(first)[i].saveState(writer); };
+			type.mLoadRows = [](void* first, int count, SnapshotReader& reader) { for (int i = 0; i < count; ++i) static_cast<T*>(first)[i].loadState(reader); };
+			type.mCheckRows = [](int count, SnapshotReader& reader) { for (int i = 0; i < count; ++i) if (!T::checkState(reader)) return false; return true; };
+		}
+
+		type.mDeclaresAccess = requires(SystemAccess& access) { T::declareAccess(UPDATE_1, access); };
+		if constexpr (requires(SystemAccess& access) { T::declareAccess(UPDATE_1, access); })
+		{
+			for (int iPhase = 0; iPhase < UPDATE_PHASE_COUNT; ++iPhase)
+			{
+				SystemAccess& access = type.mAccess[iPhase];
+				T::declareAccess(static_cast<UpdatePhase>(iPhase), access);
+				if (access.mRuns)
+					access.mWrites |= maskOf<T>();
+			}
+		}
+
+		return type;
+	}
+
+	template<typename T>
+	const ComponentType& getComponentType()
+	{
+		if (IdGen<T>::getTypeID() >= MAX_COMPONENT_TYPES)
+			throw(std::length_error{ "Error: Exceeded the maximum number of component types\n" });
+
+		static const ComponentType type = makeComponentType<T>();
+		return type;
+	}
+
+	// Blocks for one type of component, shared by every column of that type
+	// Blocks columns no longer need go on a free list instead of back to the heap
+	class BlockPool
+	{
+	public:
+		BlockPool() = delete;
+		explicit BlockPool(const ComponentType& type) : mType{ &type } {}
+		BlockPool(const BlockPool&) = delete;
+		BlockPool& operator=(const BlockPool&) = delete;
+		~BlockPool();
+
+		std::byte* allocate();
+		void release(std::byte* block);
+
+		// Frees the blocks on the free list
+		void shrink();
+
+		// Counts components as they're constructed and destroyed
+		void addLive() { mPeak = std::max(mPeak, ++mLive); }
+		void removeLive() { --mLive; }
+
+		const ComponentType& getType() const { return *mType; }
+		int getLive() const { return mLive; }
+		int getPeak() const { return mPeak; }
+		int getBlockCount() const { return mBlockCount; }
+		int getFreeBlockCount() const { return static_cast<int>(mFreeBlocks.size()); }
+
+	private:
+		const ComponentType* mType;
+		std::vector<std::byte*> mFreeBlocks;
+		int mBlockCount = 0;    // Including free blocks
+		int mLive = 0;
+		int mPeak = 0;
+	};
+
+	// Every component of one type in an archetype, stored back to back
+	// Storage grows a block at a time, so components never move when more are added
+	class ComponentColumn
+	{
+	public:
+		ComponentColumn() = delete;
+		ComponentColumn(const ComponentType& type, BlockPool& pool) : mType{ &type }, mPool{ &pool } {}
+		ComponentColumn(ComponentColumn&& other) noexcept;
+		ComponentColumn(const ComponentColumn&) = delete;
+		ComponentColumn& operator=(const ComponentColumn&) = delete;
+		~ComponentColumn();
+
+		const ComponentType& getType() const { return *mType; }
+		int size() const { return mSize; }
+
+		void* get(int row) const { return mBlocks[row / COMPONENTS_PER_BLOCK] + static_cast<std::size_t>(row % COMPONENTS_PER_BLOCK) * mType->mSize; }
+
+		// Returns uninitialized space for a component at the end of the column, the caller constructs it
+		void* pushBack();
+
+		// Destroys a component, the last component is moved into its place
+		// Spare blocks are returned to the pool, one is kept so a column at the edge of a block doesn't keep swapping it
+		void removeSwap(int row);
+
+		// Returns the spare block to the pool
+		void shrink();
+
+	private:
+		const ComponentType* mType;
+		BlockPool* mPool;
+		std::vector<std::byte*> mBlocks;
+		int mSize = 0;
+	};
+
+	// All entities with exactly the same set of component types
+	// Each entity is a row, each component type is a column
+	struct Archetype
+	{
+		// Sorted by type id
+		std::vector<const ComponentType*> mTypes;
+		std::vector<ComponentColumn> mColumns;
+
+		// 1 bit per type in the archetype, by type id
+		ComponentMask mMask = 0;
+
+		// The column holding each type, by type id, -1 if the archetype doesn't have it
+		std::array<Sint8, MAX_COMPONENT_TYPES> mColumnOfType;
+
+		// The entity (id) in each row
+		std::vector<int> mEntities;
+
+		// The archetype reached by adding a component type, by type id, filled in as they're used
+		std::array<Archetype*, MAX_COMPONENT_TYPES> mAddEdges;
+
+		Archetype() { mColumnOfType.fill(-1); mAddEdges.fill(nullptr); }
+
+		bool has(ComponentMask mask) const { return (mMask & mask) == mask; }
+
+		// Returns the column holding a type, -1 if the archetype doesn't have it
+		int findColumn(typeID id) const { return id < MAX_COMPONENT_TYPES ? mColumnOfType[id] : -1; }
+	};
+}
+
+// How much of a pool is in use
+struct PoolStats
+{
+	int mLive = 0;
+	int mPeak = 0;
+	int mCapacity = 0;    // Slots allocated, used or not
+
+	// The fraction of allocated slots that are unused
+	float getFragmentation() const { return mCapacity == 0 ? 0.f : 1.f - static_cast<float>(mLive) / static_cast<float>(mCapacity); }
+};
+
+// Refers to an entity without owning it
+// An id is reused once its entity is destroyed, the generation tells the new entity apart so old handles find nothing
+class EntityHandle
+{
+public:
+	// Refers to no entity
+	EntityHandle() = default;
+
+	bool operator==(const EntityHandle& other) const { return mValue == other.mValue; }
+	bool operator!=(const EntityHandle& other) const { return mValue != other.mValue; }
+
+	int getId() const { return static_cast<int>(mValue & WorldInternals::ENTITY_ID_MASK); }
+	Uint32 getGeneration() const { return mValue >> WorldInternals::ENTITY_ID_BITS; }
+
+private:
+	friend class World;
+	EntityHandle(int id, Uint32 generation) : mValue{ (generation << WorldInternals::ENTITY_ID_BITS) | static_cast<Uint32>(id) } {}
+
+	// Generations start at 1, so the default handle never matches
+	Uint32 mValue = 0;
+};
+
+// Owns every entity and its components, components are grouped by archetype so components of the same type are stored contiguously
+// Entities are facades over the world, see Entity
+class World
+{
+public:
+	// Updates are spread across the worker threads, 0 runs everything on the calling thread
+	explicit World(int workerCount = 0);
+	World(const World&) = delete;
+	World& operator=(const World&) = delete;
+	~World();
+
+	// Creates an entity without any components, from a pool
+	// It lives until it's killed (see Entity::kill) or the world is destroyed
+	Entity& spawnEntity();
+
+	// Returns nullptr if the entity has been destroyed
+	Entity* getEntity(EntityHandle handle) const;
+	EntityHandle getHandle(int id) const { return EntityHandle{ id, mEntities[id].mGeneration }; }
+
+	// Destroys the entity once the current update is over, so systems never see entities disappear part way through
+	void destroyLater(int id);
+
+	// Destroys the entities waiting to be destroyed, runs at the end of every update
+	void destroyQueued();
+
+	// Gives unused memory back to the heap, updates run it once enough of the entity slabs are unused
+	void compact();
+
+	// Moves the entity to the archetype with the new component, references to the entity's other components are invalidated
+	template<typename T, typename... Targs>
+	T& addComponent(int id, Targs&&... args)
+	{
+		using namespace WorldInternals;
+		const ComponentType& type = getComponentType<T>();
+
+		if (hasComponent<T>(id))
+			throw(std::invalid_argument{ "Error: Attempted to add a component the entity already has\n" });
+
+		// Construct the component before anything is moved, in case it throws
+		T component{ mEntities[id].mEntity, std::forward<Targs>(args)... };
+
+		Archetype& archetype = *getArchetypeWith(*mEntities[id].mArchetype, type);
+		moveEntity(id, archetype);
+
+		void* slot = archetype.mColumns[archetype.findColumn(type.mId)].pushBack();
+		return *new (slot) T(std::move(component));
+	}
+
+	// Returns nullptr if the entity doesn't have the component
+	template<typename T>
+	T* findComponent(int id) const
+	{
+		const EntityRecord& record = mEntities[id];
+		int column = record.mArchetype->findColumn(IdGen<T>::getTypeID());
+		return column == -1 ? nullptr : static_cast<T*>(record.mArchetype->mColumns[column].get(record.mRow));
+	}
+
+	template<typename T>
+	bool hasComponent(int id) const
+	{
+		return mEntities[id].mArchetype->findColumn(IdGen<T>::getTypeID()) != -1;
+	}
+
+	// Calls a function with the components of every entity that has all of the types, one archetype at a time
+	template<typename... Ts, typename Function>
+	void each(Function&& function)
+	{
+		static_assert(sizeof...(Ts) > 0, "Systems must use atleast 1 component type");
+
+		const WorldInternals::ComponentMask mask = (WorldInternals::maskOf<Ts>() | ...);
+		for (auto& archetype : mArchetypes)
+		{
+			if (!archetype->has(mask))
+				continue;
+
+			int columns[] = { archetype->findColumn(IdGen<Ts>::getTypeID())... };
+			eachRow<Ts...>(*archetype, columns, function, std::index_sequence_for<Ts...>{});
+		}
+	}
+
+	// Same as each, the function is also given the handle of the entity the components belong to, before the components
+	template<typename... Ts, typename Function>
+	void eachWithHandle(Function&& function)
+	{
+		static_assert(sizeof...(Ts) > 0, "Systems must use atleast 1 component type");
+
+		const WorldInternals::ComponentMask mask = (WorldInternals::maskOf<Ts>() | ...);
+		for (auto& archetype : mArchetypes)
+		{
+			if (!archetype->has(mask))
+				continue;
+
+			int columns[] = { archetype->findColumn(IdGen<Ts>::getTypeID())... };
+			eachRowWithHandle<Ts...>(*archetype, columns, function, std::index_sequence_for<Ts...>{});
+		}
+	}
+
+	// Calls a function with every component of an entity
+	template<typename Function>
+	void forEachComponent(int id, Function&& function)
+	{
+		const EntityRecord& record = mEntities[id];
+		for (auto& column : record.mArchetype->mColumns)
+			function(*column.getType().mAsComponent(column.get(record.mRow)));
+	}
+
+	// Runs each phase over every component in the world, one component type at a time
+	// Update phases are spread across the worker threads, types whose declared access doesn't conflict run at the same time
+	void handleEvents();
+	void update(float deltaTime);
+	void draw(float interpolation = 1.f);
+
+	// Shared resources that aren't safe to use from more than one thread, the types using them run on the calling thread
+	void setMainThreadResources(Uint32 resources) { mMainThreadResources = resources; }
+
+	// Runs a function on the calling thread after every component has run the phase, for work that needs every entity at once
+	void runAfterPhase(UpdatePhase phase, std::function<void(float deltaTime)> function) { mAfterPhase[phase].push_back(std::move(function)); }
+
+	// Splits a loop across the worker threads (see JobSystem::parallelFor), or runs it on the calling thread if there are none
+	void parallelFor(int count, int grainSize, const std::function<void(int begin, int end)>& function);
+
+	// Writes the state of every component whose type has saveState into the snapshot, replacing what was in it
+	// Reusing the same snapshot doesn't allocate once it's grown to fit
+	void saveSnapshot(std::vector<std::uint8_t>& snapshot) const;
+
+	// Puts every component back the way it was when the snapshot was saved, e.g. to roll back or quick load
+	// Components hold pointers to things outside the world that can't be saved, so the world must have the same entities
+	// with the same component types it had then, if not nothing is restored and it returns false
+	// Anything worked out from the components, like a spatial grid, has to be rebuilt afterwards
+	bool loadSnapshot(const std::uint8_t* data, std::size_t size);
+
+	int getEntityCount() const { return static_cast<int>(mEntities.size() - mFreeIds.size()); }
+	int getArchetypeCount() const { return static_cast<int>(mArchetypes.size()); }
+
+	template<typename T>
+	PoolStats getComponentStats() const
+	{
+		int id = IdGen<T>::getTypeID();
+		return id < WorldInternals::MAX_COMPONENT_TYPES ? getComponentStats(id) : PoolStats{};
+	}
+
+	PoolStats getComponentStats(typeID id) const;
+
+	PoolStats getEntityStats() const;
+
+private:
+	friend class Entity;
+
+	struct EntityRecord
+	{
+		Entity* mEntity = nullptr;
+		WorldInternals::Archetype* mArchetype = nullptr;
+		int mRow = -1;
+		Uint32 mGeneration = 1;    // Counts up every time the id is reused
+		bool mQueued = false;      // Waiting to be destroyed
+	};
+
+	std::vector<EntityRecord> mEntities;
+	std::vector<int> mFreeIds;
+
+	// Entities can be killed from worker threads
+	std::vector<int> mDestroyQueue;
+	std::mutex mDestroyQueueMutex;
+
+	std::unique_ptr<JobSystem> mJobs;
+	Uint32 mMainThreadResources = 0;
+	WorldInternals::ComponentMask mReportedConflicts = 0;    // Types already warned about
+	std::vector<std::function<void(float)>> mAfterPhase[UPDATE_PHASE_COUNT];
+
+	// Component pools by type id, created with the type's first column
+	std::array<std::unique_ptr<WorldInternals::BlockPool>, WorldInternals::MAX_COMPONENT_TYPES> mPools;
+
+	// Storage for entities, free slots are linked through their first bytes
+	std::vector<std::unique_ptr<std::byte[]>> mEntitySlabs;
+	void* mFreeEntity = nullptr;
+	int mPeakEntities = 0;
+	int mUpdatesSinceCompact = 0;
+
+	std::vector<std::unique_ptr<WorldInternals::Archetype>> mArchetypes;
+	WorldInternals::Archetype* mEmptyArchetype;
+
+	// Used by Entity's constructor and destructor
+	int createEntity(Entity* entity);
+	void destroyEntity(int id);
+
+	// Destroys an entity and returns its slot to the free list
+	void despawnEntity(Entity& entity);
+
+	WorldInternals::BlockPool& getPool(const WorldInternals::ComponentType& type);
+
+	// Returns the archetype with the types of another plus one more, creating it if needed
+	WorldInternals::Archetype* getArchetypeWith(WorldInternals::Archetype& archetype, const WorldInternals::ComponentType& type);
+
+	// Moves an entity's components to another archetype, the destination can have one extra column which is left for the caller
+	void moveEntity(int id, WorldInternals::Archetype& destination);
+
+	// Removes an entity's row, the last row takes its place
+	void removeRow(WorldInternals::Archetype& archetype, int row);
+
+	// Checks a snapshot fits the world before anything is restored from it
+	bool checkSnapshot(const std::uint8_t* data, std::size_t size) const;
+
+	// Runs one phase, as batches of types that can run at the same time
+	void runPhase(UpdatePhase phase, float deltaTime);
+	void runBatch(const std::vector<const WorldInternals::ComponentType*>& batch, UpdatePhase phase, float deltaTime);
+
+	// Returns the reason a type can't be spread across threads, nullptr if it can
+	const char* getSerialReason(const WorldInternals::ComponentType& type, UpdatePhase phase) const;
+
+	template<typename... Ts, typename Function, std::size_t... Is>
+	void eachRow(WorldInternals::Archetype& archetype, const int* columns, Function& function, std::index_sequence<Is...>)
+	{
+		for (int iRow = 0; iRow < static_cast<int>(archetype.mEntities.size()); ++iRow)
+			function(*static_cast<Ts*>(archetype.mColumns[columns[Is]].get(iRow))...);
+	}
+
+	template<typename... Ts, typename Function, std::size_t... Is>
+	void eachRowWithHandle(WorldInternals::Archetype& archetype, const int* columns, Function& function, std::index_sequence<Is...>)
+	{
+		for (int iRow = 0; iRow < static_cast<int>(archetype.mEntities.size()); ++iRow)
+			function(getHandle(archetype.mEntities[iRow]), *static_cast<Ts*>(archetype.mColumns[columns[Is]].get(iRow))...);
+	}
+
+	// Calls a function with every component in the world
+	template<typename Function>
+	void forEveryComponent(Function&& function)
+	{
+		for (auto& archetype : mArchetypes)
+		{
+			for (auto& column : archetype->mColumns)
+			{
+				for (int iRow = 0; iRow < column.size(); ++iRow)
+					function(*column.getType().mAsComponent(column.get(iRow)));
+			}
+		}
+	}
+};
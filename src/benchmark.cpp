@@ -0,0 +1,908 @@
+#include "../header/benchmark.h"
+#include "../header/map.h"
+#include "../header/timer.h"
+#include "../header/screen_size.h"
+#include "../header/util.h"
+#include "../header/world.h"
+#include "../header/entity.h"
+#include "../header/steering.h"
+#include "../header/spatial_grid.h"
+#include "../header/body_collider.h"
+#include "../header/pathfinder.h"
+#include "../header/components/mechanical_component.h"
+#include "../header/components/key_press_accel_component.h"
+#include "../header/components/body_component.h"
+#include "../header/components/behavior_component.h"
+#include "../header/components/map_collision_component.h"
+
+#include <SDL.h>
+#include <SDL_image.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+#define BENCHMARK_MAP "assets/tilemap.smap"
+#define RENDER_FRAMES 600
+
+// The camera circles the map's centre
+#define CAMERA_PATH_CENTRE_X 1000.f
+#define CAMERA_PATH_CENTRE_Y 1500.f
+#define CAMERA_PATH_RADIUS 800.f
+
+#define CHURN_WAVES 200
+#define CHURN_MOBS_PER_WAVE 500
+
+#define INTEGRATE_FRAMES 200
+#define INTEGRATE_DELTA_TIME (1.f / 60.f)
+#define INTEGRATE_ACCEL 3000.f
+#define INTEGRATE_TURN_PER_FRAME 0.1f
+
+#define STEERING_FRAMES 200
+#define STEERING_MAX_SPEED 800.f
+
+#define GRID_ENTITIES 50000
+#define GRID_QUERIES 2000
+#define GRID_WORLD_SIZE 4000.f
+#define GRID_CELL_SIZE 100.f
+#define GRID_RADIUS 150.f
+#define GRID_BOX_SIZE 300.f
+#define GRID_NEAREST 8
+
+#define BODY_FRAMES 120
+#define BODY_SIZE 30.f
+#define BODY_SPACING 40.f
+#define BODY_ACCEL 3000.f
+#define BODY_CROWDS_PER_SIDE 4
+
+#define SEPARATION_FRAMES 20
+// Agents packed as tightly as body collision leaves them
+#define SEPARATION_SPACING 32.f
+// A quarter of a 60 Hz frame, the rest is left for everything else
+#define BODY_BUDGET_MS 4.f
+#define BODY_BUDGET_PERCENTILE 95   // Share of frames that must be within budget, the rest allow for the odd preempted frame
+
+#define SNAPSHOT_ENTITIES 10000
+#define SNAPSHOT_REPEATS 100
+#define SNAPSHOT_CHASER_INTERVAL 4      // Every this many entities chases the first, so some have paths
+#define SNAPSHOT_WARMUP_FRAMES 30       // Long enough for the chasers to find paths
+#define SNAPSHOT_BUDGET_MS 1.f
+
+#define LOOKUP_ENTITIES 10000
+#define LOOKUP_ROUNDS 6
+#define LOOKUP_KILL_INTERVAL 5          // Every this many entities is killed and respawned bare halfway through
+
+
+namespace Benchmark
+{
+    bool run(const std::string& name)
+    {
+        if (name == "render")
+            return runMapRender();
+        if (name == "churn")
+            return runEntityChurn();
+        if (name == "integrate")
+            return runIntegration();
+        if (name == "steering")
+            return runSteering();
+        if (name == "grid")
+            return runSpatialGrid();
+        if (name == "bodies")
+            return runBodyCollision();
+        if (name == "crowd")
+            return runSeparation();
+        if (name == "snapshot")
+            return runSnapshot();
+        if (name == "lookup")
+            return runComponentLookup();
+
+        fprintf(stderr, "Unknown benchmark: %s\n", name.c_str());
+        return false;
+    }
+
+    // Returns the average frame time in milliseconds
+    static float timeMapRender(Map& map, SDL_Renderer* renderer, int frames)
+    {
+        Timer timer;
+        timer.start();
+
+        for (int iFrame = 0; iFrame < frames; ++iFrame)
+        {
+            float angle = 2.f * static_cast<float>(M_PI) * static_cast<float>(iFrame) / static_cast<float>(frames);
+            SDL_FRect camera{ CAMERA_PATH_CENTRE_X + CAMERA_PATH_RADIUS * cosf(angle), CAMERA_PATH_CENTRE_Y + CAMERA_PATH_RADIUS * sinf(angle), static_cast<float>(SCREEN_WIDTH), static_cast<float>(SCREEN_HEIGHT) };
+
+            SDL_RenderClear(renderer);
+            map.render(camera);
+            SDL_RenderPresent(renderer);
+        }
+
+        return timer.getSeconds() * 1000.f / static_cast<float>(frames);
+    }
+
+    bool runMapRender()
+    {
+        if (SDL_Init(SDL_INIT_VIDEO) < 0)
+        {
+            fprintf(stderr, "%s", SDL_GetError());
+            return false;
+        }
+
+        if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG))
+        {
+            fprintf(stderr, "%s", IMG_GetError());
+            SDL_Quit();
+            return false;
+        }
+
+        bool success = false;
+        {
+            // Hidden window, and no vsync so frames aren't capped
+            WindowPtr window{ SDL_CreateWindow("Benchmark", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_HIDDEN) };
+            RendererPtr renderer{ window ? SDL_CreateRenderer(window.get(), -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_TARGETTEXTURE) : nullptr };
+
+            if (renderer == nullptr)
+                fprintf(stderr, "%s", SDL_GetError());
+            else
+            {
+                Map map{ renderer.get(), BENCHMARK_MAP };
+
+                map.setTileRenderMode(Map::TILE_BY_TILE);
+                float tileByTile = timeMapRender(map, renderer.get(), RENDER_FRAMES);
+
+                map.setTileRenderMode(Map::BATCHED_TILES);
+                float batched = timeMapRender(map, renderer.get(), RENDER_FRAMES);
+
+                // The first frames build the cache, which is part of the cost
+                map.setTileRenderMode(Map::CACHED_TILE_LAYER);
+                float cached = timeMapRender(map, renderer.get(), RENDER_FRAMES);
+
+                printf("Map render, %d frames at %dx%d\n", RENDER_FRAMES, SCREEN_WIDTH, SCREEN_HEIGHT);
+                printf("  Tile by tile:      %.3f ms/frame\n", tileByTile);
+                printf("  Batched tiles:     %.3f ms/frame\n", batched);
+                printf("  Cached tile layer: %.3f ms/frame\n", cached);
+                success = true;
+            }
+        }
+
+        IMG_Quit();
+        SDL_Quit();
+        return success;
+    }
+
+    static void addMobComponents(Entity& mob, SDL_Event* event, int iMob)
+    {
+        float pos = static_cast<float>(iMob);
+        mob.addComponent<MechanicalComponent>(SDL_FRect{ pos, pos, 30.f, 30.f });
+        mob.addComponent<KeyPressAccelComponent>(event, 3500.f, 500.f, 7000.f);
+    }
+
+    // Returns the average milliseconds per wave
+    // Every other mob of a wave is killed a frame before the rest, so the free lists are out of order when the next wave spawns
+    static float timeChurn(World& world, bool compactEveryWave)
+    {
+        SDL_Event event{};
+        std::vector<Entity*> mobs(CHURN_MOBS_PER_WAVE, nullptr);
+
+        Timer timer;
+        timer.start();
+
+        for (int iWave = 0; iWave < CHURN_WAVES; ++iWave)
+        {
+            for (int iMob = 0; iMob < CHURN_MOBS_PER_WAVE; ++iMob)
+            {
+                mobs[iMob] = &world.spawnEntity();
+                addMobComponents(*mobs[iMob], &event, iMob);
+            }
+
+            for (int iMob = 0; iMob < CHURN_MOBS_PER_WAVE; iMob += 2)
+                mobs[iMob]->kill();
+            world.destroyQueued();
+
+            for (int iMob = 1; iMob < CHURN_MOBS_PER_WAVE; iMob += 2)
+                mobs[iMob]->kill();
+            world.destroyQueued();
+
+            if (compactEveryWave)
+                world.compact();
+        }
+
+        return timer.getSeconds() * 1000.f / static_cast<float>(CHURN_WAVES);
+    }
+
+    static void printStats(const char* name, const PoolStats& stats)
+    {
+        printf("  %-14s live %d, peak %d, capacity %d, fragmentation %.1f%%\n", name, stats.mLive, stats.mPeak, stats.mCapacity, stats.getFragmentation() * 100.f);
+    }
+
+    bool runEntityChurn()
+    {
+        // Memory stays in the pools between waves
+        World pooledWorld;
+        float pooledTime = timeChurn(pooledWorld, false);
+
+        // Memory goes back to the heap after every wave
+        World compactedWorld;
+        float compactedTime = timeChurn(compactedWorld, true);
+
+        printf("Entity churn, %d waves of %d mobs\n", CHURN_WAVES, CHURN_MOBS_PER_WAVE);
+        printf("  Pooled:                %.3f ms/wave\n", pooledTime);
+        printf("  Compacted every wave:  %.3f ms/wave\n", compactedTime);
+
+        // Pool usage halfway through killing a wave
+        SDL_Event event{};
+        std::vector<Entity*> mobs(CHURN_MOBS_PER_WAVE, nullptr);
+        for (int iMob = 0; iMob < CHURN_MOBS_PER_WAVE; ++iMob)
+        {
+            mobs[iMob] = &pooledWorld.spawnEntity();
+            addMobComponents(*mobs[iMob], &event, iMob);
+        }
+        for (int iMob = 0; iMob < CHURN_MOBS_PER_WAVE; iMob += 2)
+            mobs[iMob]->kill();
+        pooledWorld.destroyQueued();
+
+        printf("Pools with half of a wave killed\n");
+        printStats("Entities", pooledWorld.getEntityStats());
+        printStats("Mechanical", pooledWorld.getComponentStats<MechanicalComponent>());
+        printStats("KeyPressAccel", pooledWorld.getComponentStats<KeyPressAccelComponent>());
+        return true;
+    }
+
+    static void spawnMovers(World& world, int count)
+    {
+        for (int iMover = 0; iMover < count; ++iMover)
+        {
+            float pos = static_cast<float>(iMover % 1000) * 4.f;
+            world.spawnEntity().addComponent<MechanicalComponent>(SDL_FRect{ pos, pos, 30.f, 30.f });
+        }
+    }
+
+    // Turns a little every frame so the movers circle instead of speeding up forever
+    static Vec getMoverAccel(int iFrame)
+    {
+        float angle = static_cast<float>(iFrame) * INTEGRATE_TURN_PER_FRAME;
+        return Vec{ INTEGRATE_ACCEL * cosf(angle), INTEGRATE_ACCEL * sinf(angle) };
+    }
+
+    // Returns the average milliseconds per frame
+    // One at a time works out the rotation of every mover every frame, like drawing every entity would
+    static float timeIntegration(World& world, bool batched)
+    {
+        double rotationSum = 0.0;
+
+        Timer timer;
+        timer.start();
+
+        for (int iFrame = 0; iFrame < INTEGRATE_FRAMES; ++iFrame)
+        {
+            Vec accel = getMoverAccel(iFrame);
+
+            if (batched)
+            {
+                world.each<MechanicalComponent>([&accel](MechanicalComponent& mover) { mover.setAccel(accel); });
+                world.update(INTEGRATE_DELTA_TIME);
+            }
+            else
+            {
+                world.each<MechanicalComponent>([&accel, &rotationSum](MechanicalComponent& mover)
+                    {
+                        mover.update(INTEGRATE_DELTA_TIME, accel);
+                        rotationSum += mover.getRotationAngle();
+                    });
+            }
+        }
+
+        float time = timer.getSeconds() * 1000.f / static_cast<float>(INTEGRATE_FRAMES);
+
+        // Keeps the rotations from being optimized away
+        if (std::isnan(rotationSum))
+            printf("  Rotation went wrong\n");
+
+        return time;
+    }
+
+    // Returns the largest difference between the positions of the same movers in 2 worlds
+    static float getLargestDifference(World& world1, World& world2)
+    {
+        std::vector<Vec> positions;
+        world1.each<MechanicalComponent>([&positions](MechanicalComponent& mover) { positions.push_back(mover.getPos()); });
+
+        float largest = 0.f;
+        size_t iMover = 0;
+        world2.each<MechanicalComponent>([&positions, &largest, &iMover](MechanicalComponent& mover)
+            {
+                Vec difference = mover.getPos() - positions[iMover++];
+                largest = std::max({ largest, fabsf(difference.getX()), fabsf(difference.getY()) });
+            });
+
+        return largest;
+    }
+
+    bool runIntegration()
+    {
+        printf("Integration, %d frames\n", INTEGRATE_FRAMES);
+
+        for (int count : { 10000, 100000 })
+        {
+            World oneAtATimeWorld;
+            spawnMovers(oneAtATimeWorld, count);
+            float oneAtATime = timeIntegration(oneAtATimeWorld, false);
+
+            World batchedWorld;
+            spawnMovers(batchedWorld, count);
+            float batched = timeIntegration(batchedWorld, true);
+
+            printf("  %d entities\n", count);
+            printf("    One at a time: %.3f ms/frame\n", oneAtATime);
+            printf("    Batched:       %.3f ms/frame\n", batched);
+            printf("    Largest position difference: %g\n", getLargestDifference(oneAtATimeWorld, batchedWorld));
+        }
+
+        return true;
+    }
+
+    // Agents with the speeds and drag of BehaviorComponents, a few of them standing still
+    struct SteeringAgents
+    {
+        std::vector<float> mVelX;
+        std::vector<float> mVelY;
+        std::vector<float> mDragExponent;
+        std::vector<float> mDragCap;
+        std::vector<float> mAccelX;
+        std::vector<float> mAccelY;
+    };
+
+    static SteeringAgents makeSteeringAgents(int count)
+    {
+        std::mt19937 random{ 1 };
+        std::uniform_real_distribution<float> vel{ -STEERING_MAX_SPEED, STEERING_MAX_SPEED };
+        std::uniform_real_distribution<float> accelForce{ 2000.f, 6000.f };
+        std::uniform_real_distribution<float> maxVel{ 300.f, 700.f };
+
+        SteeringAgents agents;
+        for (int iAgent = 0; iAgent < count; ++iAgent)
+        {
+            bool still = iAgent % 16 == 0;
+            agents.mVelX.push_back(still ? 0.f : vel(random));
+            agents.mVelY.push_back(still ? 0.f : vel(random));
+            agents.mDragExponent.push_back(logf(accelForce(random)) / logf(maxVel(random)));
+            agents.mDragCap.push_back(7000.f);
+        }
+
+        agents.mAccelX.assign(count, 0.f);
+        agents.mAccelY.assign(count, 0.f);
+        return agents;
+    }
+
+    bool runSteering()
+    {
+        printf("Steering drag, %d frames\n", STEERING_FRAMES);
+
+        bool success = true;
+        for (int count : { 10000, 100000 })
+        {
+            SteeringAgents agents = makeSteeringAgents(count);
+            std::vector<Vec> scalarDrag(count);
+
+            Timer timer;
+            timer.start();
+            for (int iFrame = 0; iFrame < STEERING_FRAMES; ++iFrame)
+            {
+                for (int iAgent = 0; iAgent < count; ++iAgent)
+                    scalarDrag[iAgent] = Steering::getDrag(Vec{ agents.mVelX[iAgent], agents.mVelY[iAgent] }, agents.mDragExponent[iAgent], agents.mDragCap[iAgent]);
+            }
+            float scalarTime = timer.getSeconds() * 1000.f / static_cast<float>(STEERING_FRAMES);
+
+            timer.start();
+            for (int iFrame = 0; iFrame < STEERING_FRAMES; ++iFrame)
+            {
+                std::fill(agents.mAccelX.begin(), agents.mAccelX.end(), 0.f);
+                std::fill(agents.mAccelY.begin(), agents.mAccelY.end(), 0.f);
+                Steering::addDrag(agents.mVelX.data(), agents.mVelY.data(), agents.mDragExponent.data(), agents.mDragCap.data(), agents.mAccelX.data(), agents.mAccelY.data(), count);
+            }
+            float vectorTime = timer.getSeconds() * 1000.f / static_cast<float>(STEERING_FRAMES);
+
+            // Error relative to the size of the drag, still agents must have none
+            float largestError = 0.f;
+            for (int iAgent = 0; iAgent < count; ++iAgent)
+            {
+                Vec difference = Vec{ agents.mAccelX[iAgent], agents.mAccelY[iAgent] } - scalarDrag[iAgent];
+                float size = scalarDrag[iAgent].isZeroVector() ? 1.f : scalarDrag[iAgent].getMagnitude();
+                largestError = std::max(largestError, difference.getMagnitude() / size);
+            }
+
+            printf("  %d agents\n", count);
+            printf("    One at a time (powf): %.3f ms/frame\n", scalarTime);
+            printf("    Vectorised:           %.3f ms/frame\n", vectorTime);
+            printf("    Largest relative error: %g (allowed %g)\n", largestError, Steering::FAST_POW_MAX_ERROR);
+
+            if (!(largestError <= Steering::FAST_POW_MAX_ERROR))
+            {
+                fprintf(stderr, "Error: Vectorised drag is further from powf than allowed\n");
+                success = false;
+            }
+        }
+
+        return success;
+    }
+
+    // Mechanical entities of a few sizes scattered over the map
+    static void spawnScattered(World& world, int count)
+    {
+        std::mt19937 random{ 1 };
+        std::uniform_real_distribution<float> pos{ 0.f, GRID_WORLD_SIZE };
+        std::uniform_real_distribution<float> size{ 20.f, 60.f };
+
+        for (int iEntity = 0; iEntity < count; ++iEntity)
+        {
+            float side = size(random);
+            world.spawnEntity().addComponent<MechanicalComponent>(SDL_FRect{ pos(random), pos(random), side, side });
+        }
+    }
+
+    // Handles in id order, so results found in different orders can be compared
+    static void sortHandles(std::vector<EntityHandle>& handles)
+    {
+        std::sort(handles.begin(), handles.end(), [](const EntityHandle& a, const EntityHandle& b) { return a.getId() < b.getId(); });
+    }
+
+    bool runSpatialGrid()
+    {
+        printf("Spatial grid, %d entities, %d queries of each kind\n", GRID_ENTITIES, GRID_QUERIES);
+
+        World world;
+        spawnScattered(world, GRID_ENTITIES);
+
+        // The first rebuild sizes the grid's arrays, later ones reuse them like every frame does
+        SpatialGrid grid{ GRID_CELL_SIZE };
+        grid.rebuild(world);
+        Timer timer;
+        timer.start();
+        grid.rebuild(world);
+        float rebuildTime = timer.getSeconds() * 1000.f;
+
+        // Every entity as the grid saw it, for checking every entity against
+        std::vector<SpatialGrid::Entry> everyEntity;
+        everyEntity.reserve(GRID_ENTITIES);
+        grid.forEachInBox(SDL_FRect{ -GRID_WORLD_SIZE, -GRID_WORLD_SIZE, 3.f * GRID_WORLD_SIZE, 3.f * GRID_WORLD_SIZE }, [&everyEntity](const SpatialGrid::Entry& entry) { everyEntity.push_back(entry); });
+
+        std::mt19937 random{ 2 };
+        std::uniform_real_distribution<float> pos{ 0.f, GRID_WORLD_SIZE };
+        std::vector<Vec> points;
+        for (int iQuery = 0; iQuery < GRID_QUERIES; ++iQuery)
+            points.push_back(Vec{ pos(random), pos(random) });
+
+        // Room for every entity, so counts can be checked as well as handles
+        std::vector<EntityHandle> results(GRID_ENTITIES);
+        SpatialGrid::Neighbour nearest[GRID_NEAREST];
+        long long found = 0;
+
+        timer.start();
+        for (const Vec& point : points)
+            found += grid.queryRadius(point, GRID_RADIUS, results.data(), GRID_ENTITIES);
+        float radiusTime = timer.getSeconds() * 1e6f / static_cast<float>(GRID_QUERIES);
+
+        timer.start();
+        for (const Vec& point : points)
+            found += grid.queryBox(SDL_FRect{ point.getX(), point.getY(), GRID_BOX_SIZE, GRID_BOX_SIZE }, results.data(), GRID_ENTITIES);
+        float boxTime = timer.getSeconds() * 1e6f / static_cast<float>(GRID_QUERIES);
+
+        timer.start();
+        for (const Vec& point : points)
+            found += grid.findNearest(point, GRID_NEAREST, nearest);
+        float nearestTime = timer.getSeconds() * 1e6f / static_cast<float>(GRID_QUERIES);
+
+        // The same radius queries checking every entity
+        timer.start();
+        long long bruteFound = 0;
+        for (const Vec& point : points)
+        {
+            for (const SpatialGrid::Entry& entry : everyEntity)
+            {
+                float gapX = std::max({ entry.mBox.x - point.getX(), 0.f, point.getX() - (entry.mBox.x + entry.mBox.w) });
+                float gapY = std::max({ entry.mBox.y - point.getY(), 0.f, point.getY() - (entry.mBox.y + entry.mBox.h) });
+                bruteFound += gapX * gapX + gapY * gapY <= GRID_RADIUS * GRID_RADIUS;
+            }
+        }
+        float bruteTime = timer.getSeconds() * 1e6f / static_cast<float>(GRID_QUERIES);
+
+        printf("  Rebuild:              %.3f ms\n", rebuildTime);
+        printf("  Radius %.0f:           %.2f us/query\n", GRID_RADIUS, radiusTime);
+        printf("  Box %.0fx%.0f:          %.2f us/query\n", GRID_BOX_SIZE, GRID_BOX_SIZE, boxTime);
+        printf("  %d nearest:            %.2f us/query\n", GRID_NEAREST, nearestTime);
+        printf("  Radius, every entity: %.2f us/query\n", bruteTime);
+        printf("  Average found: %.1f\n", static_cast<double>(found + bruteFound) / (4.0 * GRID_QUERIES));
+
+        // Check a sample of the queries against every entity
+        bool success = true;
+        for (int iQuery = 0; iQuery < GRID_QUERIES && success; iQuery += 10)
+        {
+            const Vec& point = points[iQuery];
+            SDL_FRect area{ point.getX(), point.getY(), GRID_BOX_SIZE, GRID_BOX_SIZE };
+
+            std::vector<EntityHandle> expectedRadius;
+            std::vector<EntityHandle> expectedBox;
+            std::vector<float> expectedDistances;
+            for (const SpatialGrid::Entry& entry : everyEntity)
+            {
+                float gapX = std::max({ entry.mBox.x - point.getX(), 0.f, point.getX() - (entry.mBox.x + entry.mBox.w) });
+                float gapY = std::max({ entry.mBox.y - point.getY(), 0.f, point.getY() - (entry.mBox.y + entry.mBox.h) });
+                if (gapX * gapX + gapY * gapY <= GRID_RADIUS * GRID_RADIUS)
+                    expectedRadius.push_back(entry.mHandle);
+                if (entry.mBox.x <= area.x + area.w && area.x <= entry.mBox.x + entry.mBox.w && entry.mBox.y <= area.y + area.h && area.y <= entry.mBox.y + entry.mBox.h)
+                    expectedBox.push_back(entry.mHandle);
+
+                Vec difference = entry.mCentre - point;
+                expectedDistances.push_back(sqrtf(difference * difference));
+            }
+            std::partial_sort(expectedDistances.begin(), expectedDistances.begin() + GRID_NEAREST, expectedDistances.end());
+
+            std::vector<EntityHandle> radiusResults(results.begin(), results.begin() + grid.queryRadius(point, GRID_RADIUS, results.data(), GRID_ENTITIES));
+            std::vector<EntityHandle> boxResults(results.begin(), results.begin() + grid.queryBox(area, results.data(), GRID_ENTITIES));
+            sortHandles(expectedRadius);
+            sortHandles(expectedBox);
+            sortHandles(radiusResults);
+            sortHandles(boxResults);
+
+            // Entities the same distance away can come in either order, so only distances are compared
+            int nearestCount = grid.findNearest(point, GRID_NEAREST, nearest);
+            bool nearestMatches = nearestCount == GRID_NEAREST;
+            for (int iNearest = 0; iNearest < nearestCount && nearestMatches; ++iNearest)
+                nearestMatches = fabsf(nearest[iNearest].mDistance - expectedDistances[iNearest]) <= 1e-3f;
+
+            if (radiusResults != expectedRadius || boxResults != expectedBox || !nearestMatches)
+            {
+                fprintf(stderr, "Error: Spatial grid query at (%g, %g) doesn't match checking every entity\n", point.getX(), point.getY());
+                success = false;
+            }
+        }
+
+        return success;
+    }
+
+    // Agents on a loose grid around the centre of the map, every 10th one heavier
+    static void spawnCrowds(World& world, int count)
+    {
+        int side = static_cast<int>(ceilf(sqrtf(static_cast<float>(count))));
+        float start = GRID_WORLD_SIZE / 2.f - static_cast<float>(side) * BODY_SPACING / 2.f;
+
+        for (int iAgent = 0; iAgent < count; ++iAgent)
+        {
+            float x = start + static_cast<float>(iAgent % side) * BODY_SPACING;
+            float y = start + static_cast<float>(iAgent / side) * BODY_SPACING;
+            Entity& agent = world.spawnEntity();
+            agent.addComponent<MechanicalComponent>(SDL_FRect{ x, y, BODY_SIZE, BODY_SIZE });
+            agent.addComponent<BodyComponent>(iAgent % 10 == 0 ? 4.f : 1.f);
+        }
+    }
+
+    // The agents are split into square crowds, each heading for its own centre like chasers around different targets
+    static Vec getCrowdCentre(const Vec& pos, int count)
+    {
+        float side = ceilf(sqrtf(static_cast<float>(count))) * BODY_SPACING;
+        float start = GRID_WORLD_SIZE / 2.f - side / 2.f;
+        float crowdSide = side / static_cast<float>(BODY_CROWDS_PER_SIDE);
+
+        float crowdX = std::clamp(floorf((pos.getX() - start) / crowdSide), 0.f, BODY_CROWDS_PER_SIDE - 1.f);
+        float crowdY = std::clamp(floorf((pos.getY() - start) / crowdSide), 0.f, BODY_CROWDS_PER_SIDE - 1.f);
+        return Vec{ start + (crowdX + 0.5f) * crowdSide, start + (crowdY + 0.5f) * crowdSide };
+    }
+
+    // The deepest overlap between any 2 agents
+    static float getDeepestOverlap(World& world, const SpatialGrid& grid)
+    {
+        float deepest = 0.f;
+        world.eachWithHandle<MechanicalComponent>([&grid, &deepest](EntityHandle handle, MechanicalComponent& agent)
+            {
+                const SDL_FRect& box = agent.getCollisionBox();
+                grid.forEachInBox(box, [handle, &box, &deepest](const SpatialGrid::Entry& entry)
+                    {
+                        float overlapX = std::min(box.x + box.w, entry.mBox.x + entry.mBox.w) - std::max(box.x, entry.mBox.x);
+                        float overlapY = std::min(box.y + box.h, entry.mBox.y + entry.mBox.h) - std::max(box.y, entry.mBox.y);
+                        if (entry.mHandle != handle)
+                            deepest = std::max(deepest, std::min(overlapX, overlapY));
+                    });
+            });
+        return deepest;
+    }
+
+    bool runBodyCollision()
+    {
+        printf("Body collision, %d frames, %d worker threads, budget %.1f ms/frame\n", BODY_FRAMES, JobSystem::getDefaultWorkerCount(), BODY_BUDGET_MS);
+
+        bool success = true;
+        for (int count : { 1000, 5000 })
+        {
+            World world{ JobSystem::getDefaultWorkerCount() };
+            spawnCrowds(world, count);
+
+            SpatialGrid grid{ GRID_CELL_SIZE };
+            BodyCollider bodies;
+            Timer timer;
+            std::vector<float> frameTimes;
+            frameTimes.reserve(BODY_FRAMES);
+            long long totalContacts = 0;
+            int largestIsland = 0;
+
+            // Only the grid rebuild and the collision are timed, the same way the game runs them
+            world.runAfterPhase(INTEGRATE, [&](float deltaTime)
+                {
+                    timer.start();
+                    grid.rebuild(world);
+                    bodies.resolve(world, grid);
+                    frameTimes.push_back(timer.getSeconds() * 1000.f);
+                    totalContacts += bodies.getStats().mContacts;
+                    largestIsland = std::max(largestIsland, bodies.getStats().mLargestIsland);
+                });
+
+            for (int iFrame = 0; iFrame < BODY_FRAMES; ++iFrame)
+            {
+                world.each<MechanicalComponent>([count](MechanicalComponent& agent)
+                    {
+                        agent.setAccel(Steering::getDirection(getCrowdCentre(agent.getPos(), count) - agent.getPos()) * BODY_ACCEL);
+                        agent.setDrag(1.2f, 7000.f);
+                    });
+                world.update(INTEGRATE_DELTA_TIME);
+            }
+
+            float averageTime = 0.f;
+            for (float time : frameTimes)
+                averageTime += time / static_cast<float>(frameTimes.size());
+
+            // The budget is per frame, so it's the slow frames that are checked against it, not the average
+            std::sort(frameTimes.begin(), frameTimes.end());
+            float percentileTime = frameTimes[(frameTimes.size() - 1) * BODY_BUDGET_PERCENTILE / 100];
+            float worstTime = frameTimes.back();
+            grid.rebuild(world);
+
+            printf("  %d agents\n", count);
+            printf("    Collision: %.3f ms/frame, %dth percentile %.3f ms, worst %.3f ms\n", averageTime, BODY_BUDGET_PERCENTILE, percentileTime, worstTime);
+            printf("    Contacts: %.1f per frame, %d islands, largest %d contacts\n", static_cast<double>(totalContacts) / BODY_FRAMES, bodies.getStats().mIslands, largestIsland);
+            printf("    Deepest overlap left: %.2f\n", getDeepestOverlap(world, grid));
+
+            if (percentileTime > BODY_BUDGET_MS)
+            {
+                fprintf(stderr, "Error: Body collision for %d agents is over budget in more than %d%% of frames\n", count, 100 - BODY_BUDGET_PERCENTILE);
+                success = false;
+            }
+        }
+
+        return success;
+    }
+
+    bool runSeparation()
+    {
+        printf("Separation steering, %d frames, %d neighbours at most\n", SEPARATION_FRAMES, Steering::SEPARATION_NEIGHBOURS);
+
+        for (int count : { 100, 1000, 10000 })
+        {
+            // A square crowd packed around one target
+            World world;
+            int side = static_cast<int>(ceilf(sqrtf(static_cast<float>(count))));
+            float start = GRID_WORLD_SIZE / 2.f - static_cast<float>(side) * SEPARATION_SPACING / 2.f;
+            for (int iAgent = 0; iAgent < count; ++iAgent)
+            {
+                float x = start + static_cast<float>(iAgent % side) * SEPARATION_SPACING;
+                float y = start + static_cast<float>(iAgent / side) * SEPARATION_SPACING;
+                world.spawnEntity().addComponent<MechanicalComponent>(SDL_FRect{ x, y, BODY_SIZE, BODY_SIZE });
+            }
+
+            SpatialGrid grid{ GRID_CELL_SIZE };
+            grid.rebuild(world);
+
+            float radius = BODY_SIZE * 2.f;
+            Vec pushSum{ 0.f, 0.f };
+
+            Timer timer;
+            timer.start();
+            for (int iFrame = 0; iFrame < SEPARATION_FRAMES; ++iFrame)
+            {
+                world.eachWithHandle<MechanicalComponent>([&grid, radius, &pushSum](EntityHandle handle, MechanicalComponent& agent)
+                    {
+                        const SDL_FRect& box = agent.getCollisionBox();
+                        pushSum += Steering::getSeparation(grid, Vec{ box.x + box.w / 2.f, box.y + box.h / 2.f }, radius, handle);
+                    });
+            }
+            float time = timer.getSeconds() * 1e9f / static_cast<float>(SEPARATION_FRAMES * count);
+
+            // Keeps the pushes from being optimized away
+            if (std::isnan(pushSum.getX()))
+                printf("  Separation went wrong\n");
+
+            printf("  %5d agents: %.0f ns/agent\n", count, time);
+        }
+
+        return true;
+    }
+
+    bool runSnapshot()
+    {
+        printf("World snapshots, %d entities, 1 in %d chasing, budget %.1f ms\n", SNAPSHOT_ENTITIES, SNAPSHOT_CHASER_INTERVAL, SNAPSHOT_BUDGET_MS);
+
+        // Chasers need a map to find paths on, nothing is drawn
+        Pathfinder pathfinder{ nullptr, BENCHMARK_MAP };
+
+        World world;
+        EntityHandle target;
+        int side = static_cast<int>(ceilf(sqrtf(static_cast<float>(SNAPSHOT_ENTITIES))));
+        for (int iEntity = 0; iEntity < SNAPSHOT_ENTITIES; ++iEntity)
+        {
+            Entity& entity = world.spawnEntity();
+            float x = static_cast<float>(iEntity % side) * SEPARATION_SPACING;
+            float y = static_cast<float>(iEntity / side) * SEPARATION_SPACING;
+            entity.addComponent<MechanicalComponent>(SDL_FRect{ x, y, BODY_SIZE, BODY_SIZE });
+            entity.addComponent<BodyComponent>();
+
+            if (iEntity == 0)
+                target = entity.getHandle();
+            else if (iEntity % SNAPSHOT_CHASER_INTERVAL == 0)
+            {
+                // Swept collision carries where the last sweep ended from one update to the next
+                entity.addComponent<BehaviorComponent>(&pathfinder, target, 3500.f, 500.f, 7000.f);
+                entity.addComponent<MapCollisionComponent>(&pathfinder, MapCollisionComponent::SWEPT);
+            }
+        }
+
+        for (int iFrame = 0; iFrame < SNAPSHOT_WARMUP_FRAMES; ++iFrame)
+            world.update(INTEGRATE_DELTA_TIME);
+
+        // The first save grows the buffer, the timed ones reuse it
+        std::vector<std::uint8_t> snapshot;
+        world.saveSnapshot(snapshot);
+
+        Timer timer;
+        timer.start();
+        for (int iRepeat = 0; iRepeat < SNAPSHOT_REPEATS; ++iRepeat)
+            world.saveSnapshot(snapshot);
+        float saveTime = timer.getSeconds() * 1000.f / static_cast<float>(SNAPSHOT_REPEATS);
+
+        // Where the world goes from the snapshot, stepping the restored world must end up in the same place
+        std::vector<std::uint8_t> stepped;
+        world.update(INTEGRATE_DELTA_TIME);
+        world.saveSnapshot(stepped);
+
+        // Move everything on, then roll back
+        for (int iFrame = 0; iFrame < SNAPSHOT_WARMUP_FRAMES; ++iFrame)
+            world.update(INTEGRATE_DELTA_TIME);
+
+        bool success = true;
+        timer.start();
+        for (int iRepeat = 0; iRepeat < SNAPSHOT_REPEATS && success; ++iRepeat)
+            success = world.loadSnapshot(snapshot.data(), snapshot.size());
+        float loadTime = timer.getSeconds() * 1000.f / static_cast<float>(SNAPSHOT_REPEATS);
+
+        // Saving straight after restoring must give back the same bytes
+        std::vector<std::uint8_t> restored;
+        world.saveSnapshot(restored);
+        bool matched = success && restored == snapshot;
+
+        // State the snapshot missed would only show up once the restored world is updated
+        world.update(INTEGRATE_DELTA_TIME);
+        world.saveSnapshot(restored);
+        bool steppedMatched = matched && restored == stepped;
+
+        printf("  Size: %.1f KB\n", static_cast<double>(snapshot.size()) / 1024.0);
+        printf("  Save: %.3f ms\n", saveTime);
+        printf("  Restore: %.3f ms\n", loadTime);
+        printf("  Round trip: %s\n", matched ? "matched" : "differs");
+        printf("  Step after restore: %s\n", steppedMatched ? "matched" : "differs");
+
+        if (!matched)
+        {
+            fprintf(stderr, "Error: The restored world doesn't match the snapshot\n");
+            return false;
+        }
+        if (!steppedMatched)
+        {
+            fprintf(stderr, "Error: The restored world doesn't update the way the snapshot's world did\n");
+            return false;
+        }
+        if (saveTime > SNAPSHOT_BUDGET_MS || loadTime > SNAPSHOT_BUDGET_MS)
+        {
+            fprintf(stderr, "Error: Snapshots of %d entities are over budget\n", SNAPSHOT_ENTITIES);
+            return false;
+        }
+
+        return true;
+    }
+
+    // The types runComponentLookup adds, by bit
+    enum LookupType { LOOKUP_MECHANICAL, LOOKUP_BODY, LOOKUP_KEY_PRESS, LOOKUP_TYPE_COUNT };
+
+    // Returns the number of entities whose hasComponent doesn't match the types they were given
+    // BehaviorComponent is never added, so it must never be found
+    static int countLookupMismatches(const std::vector<Entity*>& entities, const std::vector<int>& expected, const std::vector<Vec>& spawnPos)
+    {
+        int mismatches = 0;
+        for (size_t iEntity = 0; iEntity < entities.size(); ++iEntity)
+        {
+            const Entity& entity = *entities[iEntity];
+            int found = (entity.hasComponent<MechanicalComponent>() << LOOKUP_MECHANICAL) | (entity.hasComponent<BodyComponent>() << LOOKUP_BODY)
+                | (entity.hasComponent<KeyPressAccelComponent>() << LOOKUP_KEY_PRESS);
+
+            // Components must come with the entity when it moves to another archetype
+            bool movedIntact = !(found & expected[iEntity] & (1 << LOOKUP_MECHANICAL)) || entity.getComponent<MechanicalComponent>().getPos() == spawnPos[iEntity];
+
+            if (found != expected[iEntity] || entity.hasComponent<BehaviorComponent>() || !movedIntact)
+                ++mismatches;
+        }
+        return mismatches;
+    }
+
+    bool runComponentLookup()
+    {
+        printf("Component lookup, %d entities, %d rounds of adding components\n", LOOKUP_ENTITIES, LOOKUP_ROUNDS);
+
+        World world;
+        SDL_Event event{};
+        std::mt19937 random{ 7 };
+
+        std::vector<Entity*> entities(LOOKUP_ENTITIES);
+        std::vector<int> expected(LOOKUP_ENTITIES, 0);
+        std::vector<Vec> spawnPos(LOOKUP_ENTITIES);
+        for (int iEntity = 0; iEntity < LOOKUP_ENTITIES; ++iEntity)
+        {
+            entities[iEntity] = &world.spawnEntity();
+            spawnPos[iEntity] = Vec{ static_cast<float>(iEntity), 0.f };
+        }
+
+        bool success = true;
+        float lookupTime = 0.f;
+        for (int iRound = 0; iRound < LOOKUP_ROUNDS; ++iRound)
+        {
+            // Each entity gets one of the types it doesn't have yet, in a random order, moving it to another archetype
+            for (int iEntity = 0; iEntity < LOOKUP_ENTITIES; ++iEntity)
+            {
+                if (expected[iEntity] == (1 << LOOKUP_TYPE_COUNT) - 1 || random() % 2 == 0)
+                    continue;
+
+                int type;
+                do
+                    type = static_cast<int>(random() % LOOKUP_TYPE_COUNT);
+                while (expected[iEntity] & (1 << type));
+
+                Entity& entity = *entities[iEntity];
+                if (type == LOOKUP_MECHANICAL)
+                    entity.addComponent<MechanicalComponent>(SDL_FRect{ spawnPos[iEntity].getX(), spawnPos[iEntity].getY(), BODY_SIZE, BODY_SIZE });
+                else if (type == LOOKUP_BODY)
+                    entity.addComponent<BodyComponent>();
+                else
+                    entity.addComponent<KeyPressAccelComponent>(&event, 5000.f, 500.f, 7000.f);
+                expected[iEntity] |= 1 << type;
+            }
+
+            // Killed entities' ids are reused by the new ones, which must start without the old components
+            if (iRound == LOOKUP_ROUNDS / 2)
+            {
+                for (int iEntity = 0; iEntity < LOOKUP_ENTITIES; iEntity += LOOKUP_KILL_INTERVAL)
+                    entities[iEntity]->kill();
+                world.destroyQueued();
+
+                for (int iEntity = 0; iEntity < LOOKUP_ENTITIES; iEntity += LOOKUP_KILL_INTERVAL)
+                {
+                    entities[iEntity] = &world.spawnEntity();
+                    expected[iEntity] = 0;
+                }
+            }
+
+            Timer timer;
+            timer.start();
+            int mismatches = countLookupMismatches(entities, expected, spawnPos);
+            lookupTime += timer.getSeconds();
+
+            if (mismatches != 0)
+            {
+                fprintf(stderr, "Error: %d entities' components don't match what they were given after round %d\n", mismatches, iRound + 1);
+                success = false;
+            }
+        }
+
+        // Four hasComponent calls per entity per round, the getComponent calls are included
+        printf("  %d archetypes, %.1f ns/lookup\n", world.getArchetypeCount(), lookupTime * 1e9f / static_cast<float>(LOOKUP_ROUNDS * LOOKUP_ENTITIES * 4));
+        printf("  Lookups: %s\n", success ? "matched" : "differ");
+        return success;
+    }
+}
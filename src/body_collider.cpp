@@ -0,0 +1,204 @@
+#include "../header/body_collider.h"
+#include "../header/collision.h"
+#include "../header/spatial_grid.h"
+#include "../header/world.h"
+#include "../header/components/body_component.h"
+#include "../header/components/mechanical_component.h"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <vector>
+
+// Each island's contacts are separated this many times, pushing one pair apart can push it into another
+#define SOLVER_ITERATIONS 4
+
+// Pairs this close are kept as contacts as well, so the solver notices when pushing one pair apart pushes another together
+#define CONTACT_MARGIN 8.f
+
+// Islands handed to a thread at a time
+#define ISLANDS_PER_JOB 16
+#define BODIES_PER_JOB 256
+
+
+void BodyCollider::resolve(World& world, const SpatialGrid& grid)
+{
+    gatherBodies(world);
+    findContacts(grid);
+    buildIslands();
+
+    world.parallelFor(mStats.mIslands, ISLANDS_PER_JOB, [this](int begin, int end)
+        {
+            for (int iIsland = begin; iIsland < end; ++iIsland)
+                solveIsland(iIsland);
+        });
+
+    // Every body is in at most one island, so bodies can be written back in any order
+    world.parallelFor(static_cast<int>(mBodies.size()), BODIES_PER_JOB, [this](int begin, int end)
+        {
+            for (int iBody = begin; iBody < end; ++iBody)
+            {
+                Body& body = mBodies[iBody];
+                Vec moved{ body.mBox.x - body.mStartX, body.mBox.y - body.mStartY };
+                if (moved.isZeroVector())
+                    continue;
+
+                body.mMechComp->addToPos(moved);
+
+                // Stop moving into the bodies it was pushed out of
+                Vec vel = body.mMechComp->getVel();
+                if (moved.getX() * vel.getX() < 0.f)
+                    vel.setX(0.f);
+                if (moved.getY() * vel.getY() < 0.f)
+                    vel.setY(0.f);
+                body.mMechComp->setVel(vel);
+            }
+        });
+}
+
+void BodyCollider::gatherBodies(World& world)
+{
+    mBodies.clear();
+    std::fill(mBodyIndex.begin(), mBodyIndex.end(), -1);
+
+    world.eachWithHandle<MechanicalComponent, BodyComponent>([this](EntityHandle handle, MechanicalComponent& mechComp, BodyComponent& body)
+        {
+            if (handle.getId() >= static_cast<int>(mBodyIndex.size()))
+                mBodyIndex.resize(handle.getId() + 1, -1);
+            mBodyIndex[handle.getId()] = static_cast<int>(mBodies.size());
+
+            const SDL_FRect& box = mechComp.getCollisionBox();
+            mBodies.push_back(Body{ &mechComp, handle, box, box.x, box.y, body.getInverseMass() });
+        });
+
+    mStats = Stats{};
+    mStats.mBodies = static_cast<int>(mBodies.size());
+}
+
+void BodyCollider::findContacts(const SpatialGrid& grid)
+{
+    mContacts.clear();
+
+    for (int iBody = 0; iBody < static_cast<int>(mBodies.size()); ++iBody)
+    {
+        const Body& body = mBodies[iBody];
+        SDL_FRect area{ body.mBox.x - CONTACT_MARGIN, body.mBox.y - CONTACT_MARGIN, body.mBox.w + 2.f * CONTACT_MARGIN, body.mBox.h + 2.f * CONTACT_MARGIN };
+
+        grid.forEachInBox(area, [this, iBody, &body, &area](const SpatialGrid::Entry& entry)
+            {
+                // Each pair is found from both sides, it's kept from the body that comes first
+                int id = entry.mHandle.getId();
+                int other = id < static_cast<int>(mBodyIndex.size()) ? mBodyIndex[id] : -1;
+                if (other <= iBody || mBodies[other].mHandle != entry.mHandle)
+                    return;
+
+                // Two bodies that can't be pushed stay where they are
+                if (body.mInverseMass + mBodies[other].mInverseMass == 0.f)
+                    return;
+
+                if (checkCollision(area, mBodies[other].mBox))
+                    mContacts.push_back(Contact{ iBody, other });
+            });
+    }
+
+    mStats.mContacts = static_cast<int>(mContacts.size());
+}
+
+void BodyCollider::buildIslands()
+{
+    int bodyCount = static_cast<int>(mBodies.size());
+    mParents.resize(bodyCount);
+    for (int iBody = 0; iBody < bodyCount; ++iBody)
+        mParents[iBody] = iBody;
+
+    // Bodies that can't be pushed don't join islands, otherwise everything touching a wall-like body would be solved together
+    for (const Contact& contact : mContacts)
+    {
+        if (mBodies[contact.mA].mInverseMass == 0.f || mBodies[contact.mB].mInverseMass == 0.f)
+            continue;
+
+        int rootA = findRoot(contact.mA);
+        int rootB = findRoot(contact.mB);
+        if (rootA != rootB)
+            mParents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+    }
+
+    // Islands are numbered in the order their first contact was found, so they're solved the same way every time
+    mIslandOfRoot.assign(bodyCount, -1);
+    mContactIslands.resize(mContacts.size());
+    int islandCount = 0;
+    for (size_t iContact = 0; iContact < mContacts.size(); ++iContact)
+    {
+        const Contact& contact = mContacts[iContact];
+        int root = findRoot(mBodies[contact.mA].mInverseMass == 0.f ? contact.mB : contact.mA);
+        if (mIslandOfRoot[root] == -1)
+            mIslandOfRoot[root] = islandCount++;
+        mContactIslands[iContact] = mIslandOfRoot[root];
+    }
+
+    // Counting sort of the contacts by island, keeping the order they were found in
+    mIslandStarts.assign(islandCount + 1, 0);
+    for (int island : mContactIslands)
+        ++mIslandStarts[island + 1];
+    for (int iIsland = 0; iIsland < islandCount; ++iIsland)
+    {
+        mStats.mLargestIsland = std::max(mStats.mLargestIsland, mIslandStarts[iIsland + 1]);
+        mIslandStarts[iIsland + 1] += mIslandStarts[iIsland];
+    }
+
+    // Each island's start is moved up as it's filled, then moved back
+    mIslandContacts.resize(mContacts.size());
+    for (size_t iContact = 0; iContact < mContacts.size(); ++iContact)
+        mIslandContacts[mIslandStarts[mContactIslands[iContact]]++] = mContacts[iContact];
+
+    for (int iIsland = islandCount; iIsland > 0; --iIsland)
+        mIslandStarts[iIsland] = mIslandStarts[iIsland - 1];
+    mIslandStarts[0] = 0;
+
+    mStats.mIslands = islandCount;
+}
+
+void BodyCollider::solveIsland(int island)
+{
+    for (int iIteration = 0; iIteration < SOLVER_ITERATIONS; ++iIteration)
+    {
+        for (int iContact = mIslandStarts[island]; iContact < mIslandStarts[island + 1]; ++iContact)
+        {
+            Body& a = mBodies[mIslandContacts[iContact].mA];
+            Body& b = mBodies[mIslandContacts[iContact].mB];
+
+            // An earlier contact may have already pushed them apart
+            if (!checkCollision(a.mBox, b.mBox))
+                continue;
+
+            // The lighter body moves further
+            // Bodies that can't be pushed can touch several islands, they're only read so islands on other threads can share them
+            Vec separation = findSeparation(a.mBox, b.mBox);
+            float totalInverseMass = a.mInverseMass + b.mInverseMass;
+
+            if (a.mInverseMass > 0.f)
+            {
+                Vec moveA = separation * (a.mInverseMass / totalInverseMass);
+                a.mBox.x += moveA.getX();
+                a.mBox.y += moveA.getY();
+            }
+            if (b.mInverseMass > 0.f)
+            {
+                Vec moveB = separation * (b.mInverseMass / totalInverseMass);
+                b.mBox.x -= moveB.getX();
+                b.mBox.y -= moveB.getY();
+            }
+        }
+    }
+}
+
+int BodyCollider::findRoot(int body)
+{
+    // Path halving, every other body on the way up is pointed at its grandparent
+    while (mParents[body] != body)
+    {
+        mParents[body] = mParents[mParents[body]];
+        body = mParents[body];
+    }
+    return body;
+}
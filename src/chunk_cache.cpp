@@ -0,0 +1,182 @@
+#include "../header/chunk_cache.h"
+#include "../header/map_format.h"
+
+#include <SDL.h>
+
+#include <cstdio>
+#include <algorithm>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Enough chunks to cover the screen and its surroundings, kept even if the budget is smaller
+#define MIN_RESIDENT_CHUNKS 16
+
+
+using namespace MapInternals;
+
+ChunkCache::ChunkCache(const Uint8* mapData, std::size_t mapSize, std::size_t memoryBudget) : mMapData{ mapData }, mMapSize{ mapSize }
+{
+    const MapFormat::Header& header = *MapFormat::getHeader(mapData, mapSize);
+
+    mChunkSideLength = static_cast<int>(header.mChunkSideLength);
+    mChunksPerRow = MapFormat::getChunksPerRow(header);
+
+    std::size_t tilesPerChunk = static_cast<std::size_t>(mChunkSideLength) * mChunkSideLength;
+    mChunkBytes = sizeof(Chunk) + tilesPerChunk + MapFormat::getWallBitsWordCount(tilesPerChunk) * sizeof(Uint64);
+    mMaxResidentChunks = std::max(memoryBudget / mChunkBytes, static_cast<std::size_t>(MIN_RESIDENT_CHUNKS));
+
+    mLoader = std::thread{ &ChunkCache::runLoader, this };
+}
+
+ChunkCache::~ChunkCache()
+{
+    {
+        std::lock_guard<std::mutex> lock{ mMutex };
+        mQuit = true;
+    }
+    mLoaderWake.notify_one();
+    mLoader.join();
+}
+
+void ChunkCache::request(int firstRow, int firstCol, int lastRow, int lastCol)
+{
+    bool queued = false;
+
+    for (int iChunkRow = firstRow / mChunkSideLength; iChunkRow <= lastRow / mChunkSideLength; ++iChunkRow)
+    {
+        for (int iChunkCol = firstCol / mChunkSideLength; iChunkCol <= lastCol / mChunkSideLength; ++iChunkCol)
+        {
+            int index = iChunkRow * mChunksPerRow + iChunkCol;
+
+            // Keep chunks in use away from eviction
+            auto resident = mResidentLookup.find(index);
+            if (resident != mResidentLookup.end())
+            {
+                mResident.splice(mResident.begin(), mResident, resident->second);
+                continue;
+            }
+
+            // Already on its way
+            if (mPending.insert(index).second == false)
+                continue;
+
+            std::lock_guard<std::mutex> lock{ mMutex };
+            mRequests.push_back(index);
+            queued = true;
+        }
+    }
+
+    if (queued)
+        mLoaderWake.notify_one();
+}
+
+void ChunkCache::update()
+{
+    std::vector<Chunk> finished;
+    {
+        std::lock_guard<std::mutex> lock{ mMutex };
+        finished.swap(mFinished);
+    }
+
+    for (Chunk& chunk : finished)
+    {
+        mPending.erase(chunk.mIndex);
+
+        // The chunk may have been needed before the loader got to it
+        if (mResidentLookup.count(chunk.mIndex) == 0)
+            insert(std::move(chunk));
+    }
+}
+
+void ChunkCache::findChunk(int index)
+{
+    auto resident = mResidentLookup.find(index);
+
+    if (resident != mResidentLookup.end())
+    {
+        mResident.splice(mResident.begin(), mResident, resident->second);
+    }
+    else
+    {
+        // Not loaded yet, can't wait for the loader
+        Chunk chunk;
+        decode(index, chunk);
+        insert(std::move(chunk));
+    }
+
+    mLastIndex = index;
+    mLastChunk = &mResident.front();
+}
+
+void ChunkCache::insert(Chunk&& chunk)
+{
+    int index = chunk.mIndex;
+    mResident.push_front(std::move(chunk));
+    mResidentLookup[index] = mResident.begin();
+
+    evict();
+}
+
+void ChunkCache::evict()
+{
+    // The front chunk is the newest, it's never evicted
+    while (mResident.size() > mMaxResidentChunks)
+    {
+        int index = mResident.back().mIndex;
+        if (index == mLastIndex)
+        {
+            mLastIndex = -1;
+            mLastChunk = nullptr;
+        }
+
+        mResidentLookup.erase(index);
+        mResident.pop_back();
+    }
+}
+
+void ChunkCache::decode(int index, Chunk& chunk) const
+{
+    std::size_t tilesPerChunk = static_cast<std::size_t>(mChunkSideLength) * mChunkSideLength;
+
+    chunk.mIndex = index;
+    chunk.mTypes.assign(tilesPerChunk, MISC_TILE);
+    chunk.mWallBits.assign(MapFormat::getWallBitsWordCount(tilesPerChunk), 0);
+
+    // A corrupt chunk is walled off rather than taking the game down mid-play
+    if (MapFormat::decompressChunk(mMapData, mMapSize, static_cast<std::size_t>(index), chunk.mTypes.data(), static_cast<std::size_t>(mChunkSideLength)) == false)
+    {
+        fprintf(stderr, "Failed to load map chunk %d: corrupt chunk\n", index);
+        chunk.mTypes.assign(tilesPerChunk, WALL_TILE);
+    }
+
+    for (std::size_t iTile = 0; iTile < tilesPerChunk; ++iTile)
+    {
+        if (chunk.mTypes[iTile] == WALL_TILE)
+            chunk.mWallBits[iTile >> 6] |= (Uint64{ 1 } << (iTile & 63));
+    }
+}
+
+void ChunkCache::runLoader()
+{
+    std::unique_lock<std::mutex> lock{ mMutex };
+
+    while (true)
+    {
+        mLoaderWake.wait(lock, [this]() { return mQuit || !mRequests.empty(); });
+        if (mQuit)
+            return;
+
+        int index = mRequests.front();
+        mRequests.pop_front();
+
+        // Decode without holding the lock so lookups and new requests aren't blocked
+        lock.unlock();
+        Chunk chunk;
+        decode(index, chunk);
+        lock.lock();
+
+        mFinished.push_back(std::move(chunk));
+    }
+}
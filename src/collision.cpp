@@ -76,23 +76,18 @@ bool checkCollision(const SDL_FRect& a, const SDL_FRect& b)
     return true;
 }
 
-float findIntersectionX(const SDL_FRect& obj1, const SDL_Rect& obj2)
+float findIntersectionX(const SDL_FRect& obj1, const SDL_FRect& obj2)
 {
     // The sides of the rectangles
     float leftA, leftB;
     float rightA, rightB;
 
     const SDL_FRect* a = &obj1;
+    const SDL_FRect* b = &obj2;
 
-    // Convert obj2 to floating point values
-    SDL_FRect floatObj2;
-    convert(obj2, floatObj2);
-    const SDL_FRect* b = &floatObj2;
-
-
-    if (obj1.w > floatObj2.w)
+    if (obj1.w > obj2.w)
     {
-        a = &floatObj2;
+        a = &obj2;
         b = &obj1;
     }
 
@@ -108,27 +103,27 @@ float findIntersectionX(const SDL_FRect& obj1, const SDL_Rect& obj2)
     else if (rightA > rightB)
         mCorrectionX = rightB - leftA;
     else
-        mCorrectionX = a->w;
+        return a->w;
+
+    // When the entity is the larger box the correction was found for the other box, the entity moves the opposite way
+    if (a != &obj1)
+        mCorrectionX = -mCorrectionX;
     
     return mCorrectionX;
 }
 
-float findIntersectionY(const SDL_FRect& obj1, const SDL_Rect& obj2)
+float findIntersectionY(const SDL_FRect& obj1, const SDL_FRect& obj2)
 {
     // The sides of the rectangles
     float topA, topB;
     float bottomA, bottomB;
 
     const SDL_FRect* a = &obj1;
-
-    // Convert obj2 to floating point values
-    SDL_FRect floatObj2;
-    convert(obj2, floatObj2);
-    const SDL_FRect* b = &floatObj2;
+    const SDL_FRect* b = &obj2;
 
     if (obj1.h > obj2.h)
     {
-        a = &floatObj2;
+        a = &obj2;
         b = &obj1;
     }
 
@@ -144,38 +139,55 @@ float findIntersectionY(const SDL_FRect& obj1, const SDL_Rect& obj2)
     else if (bottomA > bottomB)
         mCorrectionY = bottomB - topA;
     else
-        mCorrectionY = a->h;
+        return a->h;
+
+    // The entity moves the opposite way when it's the larger box
+    if (a != &obj1)
+        mCorrectionY = -mCorrectionY;
     return mCorrectionY;
 }
 
 
- void buildCollisionReport(const SDL_FRect& entity, const std::vector<SDL_Rect>& collidedTiles, Vec& adjustPos)
+void buildCollisionReport(const SDL_FRect& entity, const std::vector<SDL_Rect>& collidedTiles, Vec& adjustPos)
+{
+    for (const SDL_Rect& collidedTile : collidedTiles)
+        addToCollisionReport(entity, collidedTile, adjustPos);
+}
+
+Vec findSeparation(const SDL_FRect& entity, const SDL_FRect& other)
+{
+    Vec correction;
+
+    // Find intersections on both axi
+    float mCorrectionX = findIntersectionX(entity, other);
+    float mCorrectionY = findIntersectionY(entity, other);
+
+    // Identify the shallow axis
+    if (abs(mCorrectionX) < abs(mCorrectionY))
+        correction.setX(mCorrectionX);
+    else
+        correction.setY(mCorrectionY);
+
+    return correction;
+}
+
+void addToCollisionReport(const SDL_FRect& entity, const SDL_Rect& collidedTile, Vec& adjustPos)
 {
-    for (int iTile = 0; iTile < collidedTiles.size(); ++iTile)
+    // Convert the tile to floating point values
+    SDL_FRect floatTile;
+    convert(collidedTile, floatTile);
+    Vec correction = findSeparation(entity, floatTile);
+    
+    // If overall adjustment is 0, set it to the current correction
+    if (adjustPos.getMagnitude() == 0.f)
+        adjustPos = correction;
+
+    // Otherwise, add only the extra direction to the overall adjustment
+    else
     {
-        Vec correction;
-
-        // Find intersections on both axi
-        float mCorrectionX = findIntersectionX(entity, collidedTiles[iTile]);
-        float mCorrectionY = findIntersectionY(entity, collidedTiles[iTile]);
-
-        // Identify the shallow axis
-        if (abs(mCorrectionX) < abs(mCorrectionY))
-            correction.setX(mCorrectionX);
-        else
-            correction.setY(mCorrectionY);
-        
-        // If overall adjustment is 0, set it to the current correction
-        if (adjustPos.getMagnitude() == 0.f)
-            adjustPos = correction;
-
-        // Otherwise, add only the extra direction to the overall adjustment
-        else
-        {
-            float duplicate = correction.scalarProjectOn(adjustPos);
-            duplicate /= adjustPos.getMagnitude();
-            duplicate = std::min(duplicate, 1.f);
-            adjustPos += correction - (duplicate * adjustPos);
-        }
+        float duplicate = correction.scalarProjectOn(adjustPos);
+        duplicate /= adjustPos.getMagnitude();
+        duplicate = std::min(duplicate, 1.f);
+        adjustPos += correction - (duplicate * adjustPos);
     }
 }
@@ -2,11 +2,31 @@
 #include "../../header/components/component.h"
 #include "../../header/components/mechanical_component.h"
 #include "../../header/pathfinder.h"
+#include "../../header/steering.h"
 #include "../../header/entity.h"
 #include "../../header/vec.h"
+#include "../../header/snapshot.h"
 
+#include <cstdint>
+#include <deque>
+#include <stack>
 
-BehaviorComponent::BehaviorComponent(Entity* owner, Pathfinder* pathfinder, const Entity* target, float accelForce, float maxVel, float dragCap)
+#define WALL_AVOIDANCE_DISTANCE 20.f    // Gap to a wall that agents start steering away at
+#define WALL_AVOIDANCE_STRENGTH 0.5f    // Fraction of the acceleration force used to push off of a wall being touched
+#define SEPARATION_RADIUS 2.f           // Agents steer apart from others within this many of their own widths
+#define SEPARATION_STRENGTH 0.6f        // Fraction of the acceleration force used to push away from agents that are touching
+
+namespace
+{
+    // std::stack keeps its container protected, a type derived from it can hand it out so paths are saved without popping a copy
+    struct PathContainer : std::stack<SDL_Point>
+    {
+        static std::deque<SDL_Point>& get(std::stack<SDL_Point>& path) { return path.*&PathContainer::c; }
+        static const std::deque<SDL_Point>& get(const std::stack<SDL_Point>& path) { return path.*&PathContainer::c; }
+    };
+}
+
+BehaviorComponent::BehaviorComponent(Entity* owner, Pathfinder* pathfinder, EntityHandle target, float accelForce, float maxVel, float dragCap)
     : Component{ owner }, mTarget{ target }, mAccelForce{ accelForce }, mMaxVel{ maxVel }, mDragCap{ dragCap }
 {
     ++mObjCount;
@@ -16,7 +36,7 @@ BehaviorComponent::BehaviorComponent(Entity* owner, Pathfinder* pathfinder, cons
      mDragExponent = log(mAccelForce) / log(mMaxVel);   // Exponent = log[base: max vel](accel force)
 }
 
-BehaviorComponent::BehaviorComponent(Entity* owner, Pathfinder* pathfinder, const Entity* target, float accelForce, float maxVel, float dragCap, const Vec& accel)
+BehaviorComponent::BehaviorComponent(Entity* owner, Pathfinder* pathfinder, EntityHandle target, float accelForce, float maxVel, float dragCap, const Vec& accel)
     : Component{ owner }, mTarget{ target }, mAccelForce{ accelForce }, mMaxVel{ maxVel }, mDragCap{ dragCap }, mAccel{ accel }
 {
     ++mObjCount;
@@ -26,12 +46,20 @@ BehaviorComponent::BehaviorComponent(Entity* owner, Pathfinder* pathfinder, cons
     mDragExponent = log(mAccelForce) / log(mMaxVel);   // Exponent = log[base: max vel](accel force)
 }
 
+// Components are moved when their entity changes archetype
+BehaviorComponent::BehaviorComponent(BehaviorComponent&& other) noexcept
+    : Component{ other }, mTarget{ other.mTarget }, mTargetPos{ other.mTargetPos }, mHasTarget{ other.mHasTarget }, mAccelForce{ other.mAccelForce },
+    mMaxVel{ other.mMaxVel }, mDragExponent{ other.mDragExponent }, mDragCap{ other.mDragCap }, mAccel{ other.mAccel }, mElapsedTime{ other.mElapsedTime },
+    mPath{ std::move(other.mPath) }
+{
+    ++mObjCount;
+}
+
 BehaviorComponent::~BehaviorComponent()
 {
     // Remove static reference if this is the last object being destroyed
     if (mObjCount == 1)
     {
-        mTarget = nullptr;
         mPathfinder = nullptr;
     }
     --mObjCount;
@@ -52,36 +80,45 @@ void BehaviorComponent::update1(float deltaTime)
     // Get reference to collision box
     const SDL_FRect& colBox = mechComp.getCollisionBox();
 
-    // Calculate the angle needed to accelerate towards the next point on the path
-    float deltaX, deltaY;
-    deltaX = static_cast<float>(mPath.top().x) - (colBox.x + colBox.w / 2.f);
-    deltaY = static_cast<float>(mPath.top().y) - (colBox.y + colBox.h / 2.f);
-    float accelAngle = atan2f(deltaY, deltaX);
+    // Set acceleration towards the next point on the path
+    Vec toPoint{ static_cast<float>(mPath.top().x) - (colBox.x + colBox.w / 2.f), static_cast<float>(mPath.top().y) - (colBox.y + colBox.h / 2.f) };
+    mAccel = Steering::getDirection(toPoint) * mAccelForce;
 
-    // Set acceleration towards the point
-    mAccel.setX(mAccelForce * cosf(accelAngle));
-    mAccel.setY(mAccelForce * sinf(accelAngle));
-    
-    // Calculate the drag force
-    if (mechComp.getVel().getX() != 0 || mechComp.getVel().getY() != 0)
+    // Steer away from nearby walls, harder the closer they are
+    Vec centre{ colBox.x + colBox.w / 2.f, colBox.y + colBox.h / 2.f };
+    float wallGap = mPathfinder->distanceToWall(centre) - std::max(colBox.w, colBox.h) / 2.f;
+    if (wallGap < WALL_AVOIDANCE_DISTANCE)
     {
-        // Find drag
-        float dragMagnitude = powf(mechComp.getVel().getMagnitude(), mDragExponent);
+        float closeness = 1.f - std::max(wallGap, 0.f) / WALL_AVOIDANCE_DISTANCE;
+        mAccel += mPathfinder->getWallGradient(centre) * (mAccelForce * WALL_AVOIDANCE_STRENGTH * closeness);
+    }
 
-        // Cap the drag (cap must be greater than the acceleration to avoid being completely canceled)
-        dragMagnitude = std::min(dragMagnitude, mDragCap);
+    // Spread out from nearby agents, so a group following the same path doesn't bunch onto the same points
+    if (mSeparationGrid != nullptr)
+    {
+        float radius = std::max(colBox.w, colBox.h) * SEPARATION_RADIUS;
+        mAccel += Steering::getSeparation(*mSeparationGrid, centre, radius, mOwner->getHandle()) * (mAccelForce * SEPARATION_STRENGTH);
+    }
 
-        // Find the drag vector, opposite direction to the velocity
-        Vec drag{ mechComp.getVel() * -1.f };
-        drag.normalize();
-        drag *= dragMagnitude;
+    // Moved by MechanicalComponent::integrate once every entity is steered, drag is worked out there for every entity at once
+    mechComp.setAccel(mAccel);
+    mechComp.setDrag(mDragExponent, mDragCap);
+}
 
-        // Apply drag to acceleration
-        mAccel += drag;
-    }
-    
-    // Update the mechanics of the entity
-    mechComp.update(deltaTime, mAccel);
+void BehaviorComponent::update3(float deltaTime)
+{
+    Entity* target = mOwner->getWorld().getEntity(mTarget);
+    mHasTarget = target != nullptr && target->hasComponent<MechanicalComponent>();
+    if (mHasTarget)
+        mTargetPos = target->getComponent<MechanicalComponent>().getPos();
+}
+
+void BehaviorComponent::declareAccess(UpdatePhase phase, SystemAccess& access)
+{
+    if (phase == UPDATE_1)
+        access.reads<MechanicalComponent>().writes<MechanicalComponent>().uses(SHARED_MAP);
+    else if (phase == UPDATE_3)
+        access.readsOthers<MechanicalComponent>();
 }
 
 bool BehaviorComponent::updatePath(float deltaTime)
@@ -89,9 +126,20 @@ bool BehaviorComponent::updatePath(float deltaTime)
     // Get reference to mechanical component
     MechanicalComponent & mechComp = mOwner->getComponent<MechanicalComponent>();
 
+    // Keep the map around the agent loaded
+    mPathfinder->prefetch(mechComp.getCollisionBox());
+
     // Add passed time to total time
     mElapsedTime += deltaTime;
 
+    // Stop following a target that's been destroyed
+    if (!mHasTarget)
+    {
+        while (!mPath.empty())
+            mPath.pop();
+        return false;
+    }
+
     // Recalculate path if sufficient time has passed and entity isn't inside a wall
     if (mElapsedTime >= 0.25f && !mPathfinder->isInWall(mechComp.getPos()))
     {
@@ -99,8 +147,10 @@ bool BehaviorComponent::updatePath(float deltaTime)
         while (!mPath.empty())
             mPath.pop();
 
-        // Get new path
-        mPathfinder->findPath(mechComp.getPos(), mTarget->getComponent<MechanicalComponent>().getPos(), mPath);
+        // Get new path, only using routes wide enough for the entity
+        const SDL_FRect& colBox = mechComp.getCollisionBox();
+        float agentRadius = std::max(colBox.w, colBox.h) / 2.f;
+        mPathfinder->findPath(mechComp.getPos(), mTargetPos, mPath, agentRadius);
         mElapsedTime = 0.f;
     }
 
@@ -123,3 +173,53 @@ bool BehaviorComponent::advancePoint()
     // Return false if path is empty
     return !mPath.empty();
 }
+
+void BehaviorComponent::saveState(SnapshotWriter& writer) const
+{
+    writer.write(mTarget);
+    writer.write(mTargetPos);
+    writer.write(mHasTarget);
+    writer.write(mAccel);
+    writer.write(mElapsedTime);
+
+    // The next point first, as it's stored
+    const std::deque<SDL_Point>& path = PathContainer::get(mPath);
+    writer.write(static_cast<std::uint32_t>(path.size()));
+    for (const SDL_Point& point : path)
+        writer.write(point);
+}
+
+void BehaviorComponent::loadState(SnapshotReader& reader)
+{
+    reader.read(mTarget);
+    reader.read(mTargetPos);
+    reader.read(mHasTarget);
+    reader.read(mAccel);
+    reader.read(mElapsedTime);
+
+    std::uint32_t pathLength = 0;
+    if (!reader.read(pathLength) || pathLength > reader.getRemaining() / sizeof(SDL_Point))
+        return;
+
+    // Refilled in place, so the path keeps the memory it already has
+    std::deque<SDL_Point>& path = PathContainer::get(mPath);
+    path.resize(pathLength);
+    for (SDL_Point& point : path)
+        reader.read(point);
+}
+
+bool BehaviorComponent::checkState(SnapshotReader& reader)
+{
+    EntityHandle target;
+    Vec targetPos;
+    std::uint8_t hasTarget = 0;
+    Vec accel;
+    float elapsedTime = 0.f;
+    std::uint32_t pathLength = 0;
+
+    // Bools are read back as bools, so they must be 0 or 1
+    if (!reader.read(target) || !reader.read(targetPos) || !reader.read(hasTarget) || hasTarget > 1 || !reader.read(accel) || !reader.read(elapsedTime) || !reader.read(pathLength))
+        return false;
+
+    return pathLength <= reader.getRemaining() / sizeof(SDL_Point) && reader.readBytes(pathLength * sizeof(SDL_Point)) != nullptr;
+}
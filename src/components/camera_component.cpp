@@ -13,9 +13,12 @@ void CameraComponent::update3(float deltaTime)
     int windowWidth = 0, windowHeight = 0;
     SDL_GetWindowSize(mWindow, &windowWidth, &windowHeight);
 
+    // Move on from where the last update left the camera
+    mPrevCamera = mCurrentCamera;
+
     // Set camera dimensions
-    mCamera.w = static_cast<int>(roundf(windowWidth));
-    mCamera.h = static_cast<int>(roundf(windowHeight));
+    mCurrentCamera.w = static_cast<int>(roundf(windowWidth));
+    mCurrentCamera.h = static_cast<int>(roundf(windowHeight));
 
     // Get reference to entity's collision box
     const SDL_FRect& collisionBox = mOwner->getComponent<MechanicalComponent>().getCollisionBox();
@@ -25,8 +28,8 @@ void CameraComponent::update3(float deltaTime)
     float destY = ((collisionBox.y + collisionBox.h / 2.f) - static_cast<float>(windowHeight) / 2.f);
 
     // Find how much to add to the camera's position using elapsed time as a percentage
-    float addX = (destX - mCamera.x) * (3.f * deltaTime);
-    float addY = (destY - mCamera.y) * (3.f * deltaTime);
+    float addX = (destX - mCurrentCamera.x) * (3.f * deltaTime);
+    float addY = (destY - mCurrentCamera.y) * (3.f * deltaTime);
 
     // Set a minimim value to increment every frame to avoid infinite approach
     if (addX < 0 && addX > -1.f)
@@ -40,20 +43,55 @@ void CameraComponent::update3(float deltaTime)
         addY = 1.f;
 
     // Add to the camera's position, but avoid overshooting the the destination
-    float tempX = mCamera.x + addX;
+    float tempX = mCurrentCamera.x + addX;
     if ((addX < 0.f && tempX < destX) || (addX > 0.f && tempX > destX))
-        mCamera.x = destX;
+        mCurrentCamera.x = destX;
     else
-        mCamera.x = tempX;
+        mCurrentCamera.x = tempX;
 
-    float tempY = mCamera.y + addY;
+    float tempY = mCurrentCamera.y + addY;
     if ((addY < 0.f && tempY < destY) || (addY > 0.f && tempY > destY))
-        mCamera.y = destY;
+        mCurrentCamera.y = destY;
     else
-        mCamera.y = tempY;
+        mCurrentCamera.y = tempY;
+
+    // Drawn where the update left it, unless it's interpolated
+    *mCamera = mCurrentCamera;
+}
+
+void CameraComponent::declareAccess(UpdatePhase phase, SystemAccess& access)
+{
+    if (phase == UPDATE_3)
+        access.reads<MechanicalComponent>().onMainThread();
+}
+
+void CameraComponent::interpolate(float interpolation)
+{
+    mCamera->x = mPrevCamera.x + (mCurrentCamera.x - mPrevCamera.x) * interpolation;
+    mCamera->y = mPrevCamera.y + (mCurrentCamera.y - mPrevCamera.y) * interpolation;
+    mCamera->w = mCurrentCamera.w;
+    mCamera->h = mCurrentCamera.h;
+}
+
+void CameraComponent::saveState(SnapshotWriter& writer) const
+{
+    writer.write(mPrevCamera);
+    writer.write(mCurrentCamera);
+}
+
+void CameraComponent::loadState(SnapshotReader& reader)
+{
+    reader.read(mPrevCamera);
+    reader.read(mCurrentCamera);
+    *mCamera = mCurrentCamera;
+}
+
+bool CameraComponent::checkState(SnapshotReader& reader)
+{
+    return reader.readBytes(2 * sizeof(SDL_FRect)) != nullptr;
 }
 
 SDL_FRect& CameraComponent::getCamera() 
 {
-    return mCamera;
+    return *mCamera;
 }
\ No newline at end of file
@@ -63,26 +63,28 @@ void KeyPressAccelComponent::update1(float deltaTime)
     else
         mAccel = mAccelDirectionVec * mAccelForce;
 
-    // Get reference to entity's velocity vector
-    const Vec& currentVel = mOwner->getComponent<MechanicalComponent>().getVel();
+    // Moved by MechanicalComponent::integrate, which adds drag as a power of the velocity
+    MechanicalComponent& mechComp = mOwner->getComponent<MechanicalComponent>();
+    mechComp.setAccel(mAccel);
+    mechComp.setDrag(mDragExponent, mDragCap);
+}
 
-    // Calculate drag, which is a power of the velocity
-    if (currentVel.getX() != 0.f || currentVel.getY() != 0.f)
-    {
-        // Find drag
-        float dragMagnitude = powf(currentVel.getMagnitude(), mDragExponent);
-        // Cap the drag (cap must be greater than the acceleration to avoid being completely canceled)
-        dragMagnitude = std::min(dragMagnitude, 7000.f);
-        // Find the drag vector, opposite direction to the velocity
-        Vec drag{ currentVel * -1.f };
-        drag.normalize();
-        drag *= dragMagnitude;
+void KeyPressAccelComponent::saveState(SnapshotWriter& writer) const
+{
+    writer.write(mAccel);
+    writer.write(mAccelDirectionVec);
+}
 
-        // Apply drag to acceleration
-        mAccel += drag;
-    }
+void KeyPressAccelComponent::loadState(SnapshotReader& reader)
+{
+    reader.read(mAccel);
+    reader.read(mAccelDirectionVec);
+}
 
-    // Update mechanics
-    mOwner->getComponent<MechanicalComponent>().update(deltaTime, mAccel);
+bool KeyPressAccelComponent::checkState(SnapshotReader& reader)
+{
+    Vec accel;
+    Vec accelDirectionVec;
+    return reader.read(accel) && reader.read(accelDirectionVec);
 }
 
@@ -8,6 +8,8 @@
 
 #include <SDL.h>
 
+#include <cstdint>
+
 
 // Detect collison with map and update mechanical component
 void MapCollisionComponent::update2(float deltaTime)
@@ -15,8 +17,68 @@ void MapCollisionComponent::update2(float deltaTime)
     MechanicalComponent& mechComp = mOwner->getComponent<MechanicalComponent>();
     // Get reference to entity's collision box
     const SDL_FRect& collisionBox = mechComp.getCollisionBox();
+
+    // Keep the surrounding map loaded
+    mMap->prefetch(collisionBox);
+
+    if (mMode == SWEPT)
+        sweep(mechComp);
     
     Vec adjustPos{ 0.f,0.f };
     if (mMap->checkWallCollisions(collisionBox, adjustPos))
         mechComp.addToPos(adjustPos);
+
+    mLastPos = mechComp.getPos();
+    mHasLastPos = true;
+}
+
+void MapCollisionComponent::declareAccess(UpdatePhase phase, SystemAccess& access)
+{
+    if (phase == UPDATE_2)
+        access.reads<MechanicalComponent>().writes<MechanicalComponent>().uses(SHARED_MAP);
+}
+
+void MapCollisionComponent::saveState(SnapshotWriter& writer) const
+{
+    writer.write(mLastPos);
+    writer.write(mHasLastPos);
+}
+
+void MapCollisionComponent::loadState(SnapshotReader& reader)
+{
+    reader.read(mLastPos);
+    reader.read(mHasLastPos);
+}
+
+bool MapCollisionComponent::checkState(SnapshotReader& reader)
+{
+    Vec lastPos;
+    std::uint8_t hasLastPos = 0;
+
+    // Bools are read back as bools, so they must be 0 or 1
+    return reader.read(lastPos) && reader.read(hasLastPos) && hasLastPos <= 1;
+}
+
+void MapCollisionComponent::sweep(MechanicalComponent& mechComp)
+{
+    // Nothing to sweep from on the first update
+    if (!mHasLastPos)
+        return;
+
+    const SDL_FRect& collisionBox = mechComp.getCollisionBox();
+    SDL_FRect startBox{ mLastPos.getX(), mLastPos.getY(), collisionBox.w, collisionBox.h };
+
+    // Replace this update's movement with the part of it that's free of walls
+    Vec moved{ mechComp.getPos() - mLastPos };
+    Vec contactNormal;
+    Vec allowed = mMap->slideBox(startBox, moved, contactNormal);
+    mechComp.addToPos(allowed - moved);
+
+    // Stop moving into the walls that were hit so the entity slides along them
+    Vec vel = mechComp.getVel();
+    if (contactNormal.getX() * vel.getX() < 0.f)
+        vel.setX(0.f);
+    if (contactNormal.getY() * vel.getY() < 0.f)
+        vel.setY(0.f);
+    mechComp.setVel(vel);
 }
@@ -1,21 +1,200 @@
 #include "../../header/components/mechanical_component.h"
+#include "../../header/steering.h"
 #include "../../header/vec.h"
 
+#include <algorithm>
 #include <cmath>
 
+// SSE2 is always there on x64, AVX only when the compiler is told to use it (/arch:AVX or -mavx)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <immintrin.h>
+#define INTEGRATE_SSE2
+#endif
+
+// If the magnitude of velocity falls below this (pixels per second), it's truncated to 0
+#define MIN_SPEED 30.f
+
+// Components are integrated this many at a time, after their coordinates are copied into arrays
+#define INTEGRATE_BATCH 64
+
+
+namespace
+{
+    // A batch of components' state, an array per coordinate so the maths runs on several components at once
+    struct Kinematics
+    {
+        alignas(32) float mPosX[INTEGRATE_BATCH];
+        alignas(32) float mPosY[INTEGRATE_BATCH];
+        alignas(32) float mVelX[INTEGRATE_BATCH];
+        alignas(32) float mVelY[INTEGRATE_BATCH];
+        alignas(32) float mAccelX[INTEGRATE_BATCH];
+        alignas(32) float mAccelY[INTEGRATE_BATCH];
+        alignas(32) float mFacingX[INTEGRATE_BATCH];
+        alignas(32) float mFacingY[INTEGRATE_BATCH];
+        alignas(32) float mDragExponent[INTEGRATE_BATCH];
+        alignas(32) float mDragCap[INTEGRATE_BATCH];
+    };
+
+    // Same steps as MechanicalComponent::update, used for the rows the vector loops leave over
+    void integrateScalar(Kinematics& k, int begin, int end, float deltaTime)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            k.mVelX[i] += k.mAccelX[i] * deltaTime;
+            k.mVelY[i] += k.mAccelY[i] * deltaTime;
+
+            if (k.mVelX[i] * k.mVelX[i] + k.mVelY[i] * k.mVelY[i] < MIN_SPEED * MIN_SPEED)
+            {
+                k.mVelX[i] = 0.f;
+                k.mVelY[i] = 0.f;
+            }
+            else
+            {
+                k.mFacingX[i] = k.mVelX[i];
+                k.mFacingY[i] = k.mVelY[i];
+            }
+
+            k.mPosX[i] += k.mVelX[i] * deltaTime;
+            k.mPosY[i] += k.mVelY[i] * deltaTime;
+        }
+    }
+
+    // Returns the number of rows done, the rest are left for integrateScalar
+    // Adds and multiplies are done in the same order as the scalar version, so the results match it exactly
+    int integrateVectors(Kinematics& k, int count, float deltaTime)
+    {
+        int i = 0;
+
+#if defined(__AVX__)
+        {
+            const __m256 dt = _mm256_set1_ps(deltaTime);
+            const __m256 minSpeedSquared = _mm256_set1_ps(MIN_SPEED * MIN_SPEED);
+
+            for (; i + 8 <= count; i += 8)
+            {
+                __m256 velX = _mm256_add_ps(_mm256_load_ps(k.mVelX + i), _mm256_mul_ps(_mm256_load_ps(k.mAccelX + i), dt));
+                __m256 velY = _mm256_add_ps(_mm256_load_ps(k.mVelY + i), _mm256_mul_ps(_mm256_load_ps(k.mAccelY + i), dt));
+
+                // Squared magnitudes are compared, no square root, lanes that are moving keep their velocity
+                __m256 speedSquared = _mm256_add_ps(_mm256_mul_ps(velX, velX), _mm256_mul_ps(velY, velY));
+                __m256 moving = _mm256_cmp_ps(speedSquared, minSpeedSquared, _CMP_NLT_UQ);
+                velX = _mm256_and_ps(moving, velX);
+                velY = _mm256_and_ps(moving, velY);
+
+                _mm256_store_ps(k.mFacingX + i, _mm256_blendv_ps(_mm256_load_ps(k.mFacingX + i), velX, moving));
+                _mm256_store_ps(k.mFacingY + i, _mm256_blendv_ps(_mm256_load_ps(k.mFacingY + i), velY, moving));
+
+                _mm256_store_ps(k.mVelX + i, velX);
+                _mm256_store_ps(k.mVelY + i, velY);
+                _mm256_store_ps(k.mPosX + i, _mm256_add_ps(_mm256_load_ps(k.mPosX + i), _mm256_mul_ps(velX, dt)));
+                _mm256_store_ps(k.mPosY + i, _mm256_add_ps(_mm256_load_ps(k.mPosY + i), _mm256_mul_ps(velY, dt)));
+            }
+        }
+#endif
+
+#if defined(INTEGRATE_SSE2)
+        {
+            const __m128 dt = _mm_set1_ps(deltaTime);
+            const __m128 minSpeedSquared = _mm_set1_ps(MIN_SPEED * MIN_SPEED);
+
+            for (; i + 4 <= count; i += 4)
+            {
+                __m128 velX = _mm_add_ps(_mm_load_ps(k.mVelX + i), _mm_mul_ps(_mm_load_ps(k.mAccelX + i), dt));
+                __m128 velY = _mm_add_ps(_mm_load_ps(k.mVelY + i), _mm_mul_ps(_mm_load_ps(k.mAccelY + i), dt));
+
+                __m128 speedSquared = _mm_add_ps(_mm_mul_ps(velX, velX), _mm_mul_ps(velY, velY));
+                __m128 moving = _mm_cmpnlt_ps(speedSquared, minSpeedSquared);
+                velX = _mm_and_ps(moving, velX);
+                velY = _mm_and_ps(moving, velY);
+
+                // No blend instruction in SSE2
+                _mm_store_ps(k.mFacingX + i, _mm_or_ps(_mm_and_ps(moving, velX), _mm_andnot_ps(moving, _mm_load_ps(k.mFacingX + i))));
+                _mm_store_ps(k.mFacingY + i, _mm_or_ps(_mm_and_ps(moving, velY), _mm_andnot_ps(moving, _mm_load_ps(k.mFacingY + i))));
+
+                _mm_store_ps(k.mVelX + i, velX);
+                _mm_store_ps(k.mVelY + i, velY);
+                _mm_store_ps(k.mPosX + i, _mm_add_ps(_mm_load_ps(k.mPosX + i), _mm_mul_ps(velX, dt)));
+                _mm_store_ps(k.mPosY + i, _mm_add_ps(_mm_load_ps(k.mPosY + i), _mm_mul_ps(velY, dt)));
+            }
+        }
+#endif
+
+        return i;
+    }
+
+    // Everything a MechanicalComponent keeps between updates, written to snapshots in one go
+    // Vec has its own copy assignment, so vectors are stored as plain floats
+    struct MechanicalState
+    {
+        float mPosX, mPosY;
+        float mVelX, mVelY;
+        SDL_FRect mCollisionBox;
+        float mAccelX, mAccelY;
+        float mDragExponent;
+        float mDragCap;
+        float mFacingX, mFacingY;
+        float mPrevPosX, mPrevPosY;
+    };
+}
+
+void MechanicalComponent::integrate(MechanicalComponent* rows, int count, float deltaTime)
+{
+    Kinematics k;
+
+    for (int first = 0; first < count; first += INTEGRATE_BATCH)
+    {
+        MechanicalComponent* batch = rows + first;
+        int batchSize = std::min(count - first, INTEGRATE_BATCH);
+
+        for (int i = 0; i < batchSize; ++i)
+        {
+            k.mPosX[i] = batch[i].mPos.getX();
+            k.mPosY[i] = batch[i].mPos.getY();
+            k.mVelX[i] = batch[i].mVel.getX();
+            k.mVelY[i] = batch[i].mVel.getY();
+            k.mAccelX[i] = batch[i].mAccel.getX();
+            k.mAccelY[i] = batch[i].mAccel.getY();
+            k.mFacingX[i] = batch[i].mFacing.getX();
+            k.mFacingY[i] = batch[i].mFacing.getY();
+            k.mDragExponent[i] = batch[i].mDragExponent;
+            k.mDragCap[i] = batch[i].mDragCap;
+            batch[i].mPrevPos = batch[i].mPos;
+        }
+
+        // Drag depends on the velocity before it's updated
+        Steering::addDrag(k.mVelX, k.mVelY, k.mDragExponent, k.mDragCap, k.mAccelX, k.mAccelY, batchSize);
+        integrateScalar(k, integrateVectors(k, batchSize, deltaTime), batchSize, deltaTime);
+
+        for (int i = 0; i < batchSize; ++i)
+        {
+            batch[i].mPos = Vec{ k.mPosX[i], k.mPosY[i] };
+            batch[i].mVel = Vec{ k.mVelX[i], k.mVelY[i] };
+            batch[i].mFacing = Vec{ k.mFacingX[i], k.mFacingY[i] };
+            batch[i].mAccel = Vec{ 0.f, 0.f };
+            batch[i].mDragExponent = 0.f;
+            batch[i].mDragCap = 0.f;
+
+            // Update collision box position as well
+            batch[i].mCollisionBox.x = k.mPosX[i];
+            batch[i].mCollisionBox.y = k.mPosY[i];
+        }
+    }
+}
 
 void MechanicalComponent::update(float deltaTime, const Vec& accel)
 {
+    mPrevPos = mPos;
+
     // Update velocity
-    mVel += accel * deltaTime;
+    mVel += (accel + Steering::getDrag(mVel, mDragExponent, mDragCap)) * deltaTime;
 
-    // If magnitude of velocity falls below 30 (pixels per second), truncate to 0
-    if (mVel.getMagnitude() < 30.f)
+    // Truncate slow velocities to 0, compared squared to save a square root
+    if (mVel * mVel < MIN_SPEED * MIN_SPEED)
         resetVel();
     else
     {
-        // Update rotation only if velocity hasn't been truncated
-        mRotationAngle = atan2(static_cast<double>(mVel.getY()), static_cast<double>(mVel.getX())) * (180.0 / M_PI);
+        // Update facing direction only if velocity hasn't been truncated
+        mFacing = mVel;
     }
 
     // Update position
@@ -26,13 +205,50 @@ void MechanicalComponent::update(float deltaTime, const Vec& accel)
     mCollisionBox.y = mPos.getY();
 }
 
-void MechanicalComponent::resetVel()  
-{ 
+void MechanicalComponent::saveState(SnapshotWriter& writer) const
+{
+    writer.write(MechanicalState{ mPos.getX(), mPos.getY(), mVel.getX(), mVel.getY(), mCollisionBox, mAccel.getX(), mAccel.getY(),
+        mDragExponent, mDragCap, mFacing.getX(), mFacing.getY(), mPrevPos.getX(), mPrevPos.getY() });
+}
+
+void MechanicalComponent::loadState(SnapshotReader& reader)
+{
+    MechanicalState state;
+    if (!reader.read(state))
+        return;
+
+    mPos = Vec{ state.mPosX, state.mPosY };
+    mVel = Vec{ state.mVelX, state.mVelY };
+    mCollisionBox = state.mCollisionBox;
+    mAccel = Vec{ state.mAccelX, state.mAccelY };
+    mDragExponent = state.mDragExponent;
+    mDragCap = state.mDragCap;
+    mFacing = Vec{ state.mFacingX, state.mFacingY };
+    mPrevPos = Vec{ state.mPrevPosX, state.mPrevPosY };
+}
+
+bool MechanicalComponent::checkState(SnapshotReader& reader)
+{
+    return reader.readBytes(sizeof(MechanicalState)) != nullptr;
+}
+
+void MechanicalComponent::setAccel(const Vec& accel) { mAccel = accel; }
+
+void MechanicalComponent::setDrag(float exponent, float cap)
+{
+    mDragExponent = exponent;
+    mDragCap = cap;
+}
+
+void MechanicalComponent::resetVel()
+{
     mVel.setX(0.f);
     mVel.setY(0.f);
-    return; 
+    return;
 }
 
+void MechanicalComponent::setVel(const Vec& vel) { mVel = vel; }
+
 void MechanicalComponent::addToPos(const Vec& toAdd)
 {
     mPos += toAdd;
@@ -47,5 +263,14 @@ const Vec& MechanicalComponent::getVel() const { return mVel; }
 
 const SDL_FRect& MechanicalComponent::getCollisionBox() {return mCollisionBox; }
 
-double MechanicalComponent::getRotationAngle() const { return mRotationAngle; }
+SDL_FRect MechanicalComponent::getInterpolatedBox(float interpolation) const
+{
+    Vec pos = mPrevPos + (mPos - mPrevPos) * interpolation;
+    return SDL_FRect{ pos.getX(), pos.getY(), mCollisionBox.w, mCollisionBox.h };
+}
 
+double MechanicalComponent::getRotationAngle() const
+{
+    // Only worked out for the entities that are drawn
+    return atan2(static_cast<double>(mFacing.getY()), static_cast<double>(mFacing.getX())) * (180.0 / M_PI);
+}
@@ -25,6 +25,12 @@ TextureComponent::TextureComponent(Entity* owner, const SDL_FRect* camera, SDL_R
 	++mObjectCount;
 }
 
+// Components are moved when their entity changes archetype
+TextureComponent::TextureComponent(TextureComponent&& other) noexcept : Component{ other }, mTexture{ std::move(other.mTexture) }
+{
+	++mObjectCount;
+}
+
 TextureComponent::~TextureComponent()
 {
 	if (mObjectCount == 1)	// If this is the last object
@@ -36,10 +42,10 @@ TextureComponent::~TextureComponent()
 	--mObjectCount;
 }
 
-void TextureComponent::draw()
+void TextureComponent::draw(float interpolation)
 {
-	// Get collision box from mechanical component
-	const SDL_FRect& collisionBox = mOwner->getComponent<MechanicalComponent>().getCollisionBox();
+	// Get collision box from mechanical component, between where it was at the start and end of the last update
+	SDL_FRect collisionBox = mOwner->getComponent<MechanicalComponent>().getInterpolatedBox(interpolation);
 	
 	float textureWidthOffset = (static_cast<float>(mTexture.getWidth()) - collisionBox.w) / 2.f;
 	float textureHeightOffset = (static_cast<float>(mTexture.getHeight()) - collisionBox.h) / 2.f;
@@ -12,6 +12,7 @@
 #include "../header/components/texture_component.h"
 #include "../header/components/camera_component.h"
 #include "../header/components/map_collision_component.h"
+#include "../header/components/body_component.h"
 
 #include "../header/util.h"
 
@@ -19,8 +20,19 @@
 #include <SDL_mixer.h>
 #include <SDL_ttf.h>
 
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
 
-GameLoader::GameLoader()
+#define DEFAULT_TICK_RATE 60.f
+
+// Frames run at most this many ticks, so a frame that falls behind doesn't make the next one fall further behind
+#define MAX_TICKS_PER_FRAME 5
+
+
+GameLoader::GameLoader(bool headless) : mHeadless{ headless }
 {
 	// Only one instance of Game is allowed
 	++mGameObjCount;
@@ -42,6 +54,18 @@ GameLoader::~GameLoader()
 
 bool GameLoader::init()
 {
+	// Headless games only need events, input still comes through them
+	if (mHeadless)
+	{
+		if (SDL_Init(SDL_INIT_EVENTS) < 0)
+		{
+			fprintf(stderr, "%s", SDL_GetError());
+			return false;
+		}
+
+		return true;
+	}
+
 	// Initialize SDL
 	if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0)
 	{
@@ -123,44 +147,69 @@ void GameLoader::close()
 	SDL_Quit();
 }
 
-Game::Game() : GameLoader{}, mMap{ mRenderer.get() }
+Game::Game(bool headless) : GameLoader{ headless }, mTickLength{ 1.f / DEFAULT_TICK_RATE }, mMap{ mRenderer.get(), "assets/tilemap.smap" }
 {
 	if (loadAssets() == false)
 		exit(-1);
+
+	// Tiles of streamed maps can't be read from worker threads
+	if (mMap.isStreamed())
+		mWorld.setMainThreadResources(SHARED_MAP);
+
+	// Chasers spread out from each other using the grid of where entities were after the last update
+	BehaviorComponent::setSeparationGrid(&mEntityGrid);
+
+	// Entities are pushed apart once they've moved, map collision then pushes them out of any walls they were pushed into
+	mWorld.runAfterPhase(INTEGRATE, [this](float deltaTime)
+		{
+			mEntityGrid.rebuild(mWorld);
+			mBodies.resolve(mWorld, mEntityGrid);
+		});
 	
 	// Initialize the timer for first frame
 	mTimer.start();
 
 	// Temp testing
 	player.addComponent<MechanicalComponent>(SDL_FRect{ 2200.f, 1500.f, 30.f, 30.f });
-	// player.addComponent<BehaviorComponent>(&mMap, &player, 3500.f, 500.f, 7000.f);
+	// player.addComponent<BehaviorComponent>(&mMap, player.getHandle(), 3500.f, 500.f, 7000.f);
 	player.addComponent<KeyPressAccelComponent>(&mEvent, 5000.f, 500.f, 7000.f);
 	player.addComponent<CameraComponent>(mWindow.get());
 	//sob.addComponent<TextureComponent>(&mPlayer.getCamera(), mRenderer.get(), "assets/images/triangle.png");
 	player.addComponent<SharedTextureComponent<int>>(&player.getComponent<CameraComponent>().getCamera(), mRenderer.get(), "assets/images/triangle.png");
-	player.addComponent<MapCollisionComponent>(&mMap);
+	player.addComponent<MapCollisionComponent>(&mMap, MapCollisionComponent::SWEPT);
+	// Heavier than the chasers, so they can't shove the player around
+	player.addComponent<BodyComponent>(4.f);
 
 
 	sob.addComponent<MechanicalComponent>(SDL_FRect{ 2200.f, 1700.f, 30.f, 30.f });
-	sob.addComponent<BehaviorComponent>(&mMap, &player, 3500.f, 500.f, 7000.f);
+	sob.addComponent<BehaviorComponent>(&mMap, player.getHandle(), 3500.f, 500.f, 7000.f);
 	// sob.addComponent<KeyPressAccelComponent>(&mEvent, 5000.f, 500.f, 7000.f);
 	// sob.addComponent<CameraComponent>(mWindow.get());
 	// sob.addComponent<TextureComponent>(&mPlayer.getCamera(), mRenderer.get(), "assets/images/triangle.png");
 	sob.addComponent<SharedTextureComponent<int>>(&player.getComponent<CameraComponent>().getCamera());
+	sob.addComponent<BodyComponent>();
 
 	bob.addComponent<MechanicalComponent>(SDL_FRect{ 100.f, 100.f, 30.f, 30.f });
-	bob.addComponent<BehaviorComponent>(&mMap, &sob, 3500.f, 500.f, 7000.f);
+	bob.addComponent<BehaviorComponent>(&mMap, sob.getHandle(), 3500.f, 500.f, 7000.f);
 	bob.addComponent<SharedTextureComponent<int>>(&player.getComponent<CameraComponent>().getCamera());
+	bob.addComponent<BodyComponent>();
 	//bob.addComponent<TextureComponent>(&mPlayer.getCamera(), mRenderer.get(), "assets/images/triangle.png");
 }
 
 Game::~Game()
 {
+	if (mRecorder != nullptr && mRecorder->save(mTickLength))
+		printf("Recorded %d ticks\n", mTickCount);
+
 	freeAssets();
 }
 
 bool Game::loadAssets()
 {
+	// Nothing to show or play them with
+	if (mHeadless)
+		return true;
+
 	// Load fontfont
 	mFont = TTF_OpenFont("assets/calibri_regular.ttf", 26);
 	if (mFont == nullptr)
@@ -261,38 +310,139 @@ void Game::handleEvents()
 		// Play the sound effect
 		else if (mEvent.type == SDL_MOUSEBUTTONDOWN)
 			Mix_PlayChannel(-1, mSoundEffect, 0);
+		// The renderer lost its textures' contents, the map's cached tiles must be redrawn
+		else if (mEvent.type == SDL_RENDER_TARGETS_RESET || mEvent.type == SDL_RENDER_DEVICE_RESET)
+			mMap.invalidateTileLayer();
 
-		player.handleEvents();
+		// Replays steer the player with the recorded input instead, see tick
+		if (mReplay == nullptr)
+		{
+			if (mRecorder != nullptr && InputRecorder::isRecorded(mEvent))
+				mRecorder->recordEvent(mEvent, mTickCount);
+			player.handleEvents();
+		}
 	}
 }
 
 void Game::update()
 {
-	// Calculate time since last frame
-	mDeltaTime = mTimer.getSeconds();
+	// Add the time since last frame
+	mAccumulator += mTimer.getSeconds();
 	
 	// Restart timer
 	mTimer.start();
 
-	player.update(mDeltaTime);
-	bob.update(mDeltaTime);
-	sob.update(mDeltaTime);
+	int ticks = 0;
+	// Replays stop the game on their last tick
+	while (mAccumulator >= mTickLength && ticks < MAX_TICKS_PER_FRAME && mRunning)
+	{
+		tick();
+		mAccumulator -= mTickLength;
+		++ticks;
+	}
 
-	
+	// Time that couldn't be caught up on, after a hitch or while paused, is dropped
+	if (mAccumulator >= mTickLength)
+		mAccumulator = fmodf(mAccumulator, mTickLength);
+}
+
+void Game::tick()
+{
+	// Recorded input goes through the same path live input does
+	if (mReplay != nullptr)
+	{
+		mReplay->forEachEvent(mTickCount, [this](const SDL_Event& event)
+			{
+				mEvent = event;
+				player.handleEvents();
+			});
+	}
+
+	mWorld.update(mTickLength);
+
+	// Entities have moved, so the grid is rebuilt before anything asks where they are
+	mEntityGrid.rebuild(mWorld);
+
+	// Stream in the map around the camera, agents request their own surroundings
+	mMap.prefetch(player.getComponent<CameraComponent>().getCamera());
+	mMap.updateStreaming();
+
+	if (mRecorder != nullptr || mReplay != nullptr)
+	{
+		std::uint64_t stateHash = ReplayFormat::hashWorld(mWorld);
+		if (mRecorder != nullptr)
+			mRecorder->recordTick(stateHash);
+		if (mReplay != nullptr && !mReplay->checkTick(mTickCount, stateHash) && mReplay->getDivergedTick() == mTickCount)
+			fprintf(stderr, "Warning: Replay diverged at tick %d\n", mTickCount);
+	}
+
+	++mTickCount;
+
+	if (mReplay != nullptr && mTickCount == mReplay->getTickCount())
+	{
+		if (mReplay->getDivergedTick() == -1)
+			printf("Replay matched for all %d ticks\n", mTickCount);
+		mRunning = false;
+	}
+}
+
+void Game::simulate(int ticks)
+{
+	Timer timer;
+	timer.start();
+
+	int iTick = 0;
+	for (; iTick < ticks && mRunning; ++iTick)
+	{
+		handleEvents();
+		tick();
+	}
+
+	float seconds = timer.getSeconds();
+	printf("Simulated %d ticks of %d entities in %.3f s, %.3f ms/tick\n", iTick, mWorld.getEntityCount(), seconds, iTick > 0 ? seconds * 1000.f / static_cast<float>(iTick) : 0.f);
+}
+
+void Game::startRecording(const std::string& path)
+{
+	mRecorder = std::make_unique<InputRecorder>(path);
+}
+
+int Game::startReplay(const std::string& path)
+{
+	auto replay = std::make_unique<InputReplay>();
+	if (!replay->load(path))
+		return -1;
+
+	mTickLength = replay->getTickLength();
+	mReplay = std::move(replay);
+	return mReplay->getTickCount();
+}
+
+void Game::setTickRate(float ticksPerSecond)
+{
+	if (!(ticksPerSecond > 0.f))
+	{
+		fprintf(stderr, "Warning: Ignored tick rate %g, it must be above 0\n", ticksPerSecond);
+		return;
+	}
+
+	mTickLength = 1.f / ticksPerSecond;
 }
 
 void Game::render()
 {
+	// How far the frame is between the last tick and the next
+	float interpolation = mAccumulator / mTickLength;
+
 	// Clear screen
 	SDL_RenderClear(mRenderer.get());
 
 	// Render the player
+	player.getComponent<CameraComponent>().interpolate(interpolation);
 	mMap.render(player.getComponent<CameraComponent>().getCamera());
 
-	// Temp
-	player.draw();
-	bob.draw();
-	sob.draw();
+	// Draw every entity
+	mWorld.draw(interpolation);
 
 	// Update screen
 	SDL_RenderPresent(mRenderer.get());
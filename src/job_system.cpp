@@ -0,0 +1,159 @@
+#include "../header/job_system.h"
+
+#include <algorithm>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+JobSystem::JobSystem(int workerCount)
+{
+    workerCount = std::max(workerCount, 0);
+
+    for (int i = 0; i <= workerCount; ++i)
+        mQueues.push_back(std::make_unique<Queue>());
+
+    for (int i = 0; i < workerCount; ++i)
+        mWorkers.emplace_back(&JobSystem::runWorker, this, i + 1);
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        std::lock_guard<std::mutex> lock{ mWakeMutex };
+        mQuit = true;
+    }
+    mWake.notify_all();
+
+    for (auto& worker : mWorkers)
+        worker.join();
+}
+
+int JobSystem::getDefaultWorkerCount()
+{
+    return std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0);
+}
+
+void JobSystem::parallelFor(int count, int grainSize, const std::function<void(int begin, int end)>& function)
+{
+    if (count <= 0)
+        return;
+
+    grainSize = std::max(grainSize, 1);
+
+    // Not worth waking the workers for
+    if (mWorkers.empty() || count <= grainSize)
+    {
+        function(0, count);
+        return;
+    }
+
+    mFunction = &function;
+    mException = nullptr;
+
+    int jobCount = (count + grainSize - 1) / grainSize;
+    mJobsLeft = jobCount;
+
+    // Each queue starts with a contiguous share of the jobs, so threads work on neighbouring data until they run out and steal
+    int queueCount = static_cast<int>(mQueues.size());
+    for (int iQueue = 0; iQueue < queueCount; ++iQueue)
+    {
+        std::lock_guard<std::mutex> lock{ mQueues[iQueue]->mMutex };
+        for (int iJob = iQueue * jobCount / queueCount; iJob < (iQueue + 1) * jobCount / queueCount; ++iJob)
+            mQueues[iQueue]->mJobs.push_back(Job{ iJob * grainSize, std::min((iJob + 1) * grainSize, count) });
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{ mWakeMutex };
+        ++mLoopCount;
+    }
+    mWake.notify_all();
+
+    runJobs(0);
+
+    // Wait for the jobs other threads took
+    {
+        std::unique_lock<std::mutex> lock{ mWakeMutex };
+        mDone.wait(lock, [this]() { return mJobsLeft == 0; });
+    }
+
+    mFunction = nullptr;
+    if (mException != nullptr)
+        std::rethrow_exception(mException);
+}
+
+void JobSystem::runWorker(int queueIndex)
+{
+    unsigned loopsSeen = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock{ mWakeMutex };
+            mWake.wait(lock, [this, loopsSeen]() { return mQuit || mLoopCount != loopsSeen; });
+
+            if (mQuit)
+                return;
+            loopsSeen = mLoopCount;
+        }
+
+        runJobs(queueIndex);
+    }
+}
+
+void JobSystem::runJobs(int queueIndex)
+{
+    Job job;
+    while (takeJob(queueIndex, job))
+    {
+        try
+        {
+            (*mFunction)(job.mBegin, job.mEnd);
+        }
+        catch (...)
+        {
+            std::lock_guard<std::mutex> lock{ mExceptionMutex };
+            if (mException == nullptr)
+                mException = std::current_exception();
+        }
+
+        // The last job wakes the thread waiting in parallelFor
+        if (--mJobsLeft == 0)
+        {
+            std::lock_guard<std::mutex> lock{ mWakeMutex };
+            mDone.notify_all();
+        }
+    }
+}
+
+bool JobSystem::takeJob(int queueIndex, Job& job)
+{
+    // The newest job from the thread's own queue
+    {
+        Queue& queue = *mQueues[queueIndex];
+        std::lock_guard<std::mutex> lock{ queue.mMutex };
+        if (!queue.mJobs.empty())
+        {
+            job = queue.mJobs.back();
+            queue.mJobs.pop_back();
+            return true;
+        }
+    }
+
+    // Otherwise the oldest job from another thread's queue
+    int queueCount = static_cast<int>(mQueues.size());
+    for (int iOffset = 1; iOffset < queueCount; ++iOffset)
+    {
+        Queue& queue = *mQueues[(queueIndex + iOffset) % queueCount];
+        std::lock_guard<std::mutex> lock{ queue.mMutex };
+        if (!queue.mJobs.empty())
+        {
+            job = queue.mJobs.front();
+            queue.mJobs.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -1,5 +1,10 @@
 #include "../header/screen_size.h"	// defined here
 #include "../header/game.h"
+#include "../header/benchmark.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 
 // Screen dimensions
 const int SCREEN_WIDTH = 1920;
@@ -8,7 +13,72 @@ const int SCREEN_HEIGHT = 1080;
 
 int main(int argc, char* args[])
 {
-	Game game;
+	// Run an offscreen benchmark instead of the game
+	if (argc == 3 && strcmp(args[1], "--benchmark") == 0)
+		return Benchmark::run(args[2]) ? 0 : -1;
+
+	// sparky [--tick-rate <rate>] [--headless --ticks <count>] [--record <file> | --replay <file>]
+	bool headless = false;
+	int ticks = -1;
+	const char* tickRate = nullptr;
+	const char* recordPath = nullptr;
+	const char* replayPath = nullptr;
+	for (int iArg = 1; iArg < argc; ++iArg)
+	{
+		if (strcmp(args[iArg], "--headless") == 0)
+			headless = true;
+		else if (strcmp(args[iArg], "--ticks") == 0 && iArg + 1 < argc)
+			ticks = atoi(args[++iArg]);
+		else if (strcmp(args[iArg], "--tick-rate") == 0 && iArg + 1 < argc)
+			tickRate = args[++iArg];
+		else if (strcmp(args[iArg], "--record") == 0 && iArg + 1 < argc)
+			recordPath = args[++iArg];
+		else if (strcmp(args[iArg], "--replay") == 0 && iArg + 1 < argc)
+			replayPath = args[++iArg];
+		else
+		{
+			fprintf(stderr, "Unknown option: %s\n", args[iArg]);
+			return -1;
+		}
+	}
+
+	// Headless replays run until the recording ends
+	if (headless != (ticks >= 0) && !(headless && replayPath != nullptr))
+	{
+		fprintf(stderr, "Error: --headless and --ticks <count> go together\n");
+		return -1;
+	}
+
+	if (recordPath != nullptr && replayPath != nullptr)
+	{
+		fprintf(stderr, "Error: --record and --replay can't be used together\n");
+		return -1;
+	}
+
+	Game game{ headless };
+	if (tickRate != nullptr)
+		game.setTickRate(static_cast<float>(atof(tickRate)));
+
+	if (recordPath != nullptr)
+		game.startRecording(recordPath);
+
+	// Replays run at the tick rate they were recorded at
+	if (replayPath != nullptr)
+	{
+		int replayTicks = game.startReplay(replayPath);
+		if (replayTicks < 0)
+			return -1;
+		if (ticks < 0)
+			ticks = replayTicks;
+	}
+
+	// Simulate without a window, as fast as possible
+	if (headless)
+	{
+		game.simulate(ticks);
+		return 0;
+	}
+
 	while (game.isRunning())
 	{
 		game.handleEvents();
@@ -1,127 +1,195 @@
 #include "../header/map.h"
+#include "../header/map_format.h"
 #include "../header/texture.h"
 #include "../header/collision.h"
 #include "../header/screen_size.h"
 #include "../header/vec.h"
+#include "../header/util.h"
+#include "../header/wall_geometry.h"
 
 #include <SDL.h>
 
-#include <fstream>
 #include <new>
 #include <vector>
 #include <string>
+#include <limits>
+#include <algorithm>
+#include <cmath>
 
-#define MAX_COLLISIONS 3
 #define MAX_NEIGHBOURS 8
+#define TRACE_STEP 10.f
+
+// Swept collisions
+#define SWEEP_SKIN 0.01f        // Distance kept from walls after a sweep, avoids touching boxes overlapping due to rounding
+#define MAX_SLIDES 3            // Walls a box can slide off of in a single move
+
+// Streamed maps
+#define CHUNK_MEMORY_BUDGET (64 * 1024 * 1024)
+#define PREFETCH_MARGIN 16          // Tiles loaded ahead around a prefetched area
+#define CLEARANCE_SEARCH_RADIUS 3   // Tiles searched around a point for its nearest wall
+
+// Distance field
+#define DISTANCE_FIELD_CELLS_PER_TILE 16
+#define MAX_DISTANCE_FIELD_SAMPLES (17 * 1024 * 1024)   // About as much memory as a 4096x4096 map's tile indices
+#define DISTANCE_FIELD_FAR 1e20f                        // Squared distance of samples with nothing to measure to
+#define SPHERE_TRACE_EPSILON 0.5f                       // Gap to a wall small enough to count as touching it
+
+#define OUT_OF_BOUNDS_REPORT_INTERVAL 1000  // In milliseconds
+
+// Cached tile layer
+#define TILE_LAYER_CHUNK_PIXELS 1024    // Largest side length of a chunk's texture
+#define MAX_TILE_LAYER_CHUNKS 32
 
 
 using namespace MapInternals;
 
-void Tile::setTile(int x, int y, int tileSideLength, tileType type)
+void TileGrid::assign(int widthInTiles, int heightInTiles, tileType fill)
 {
-    // Set tile position
-    mCollisionBox.x = x;
-    mCollisionBox.y = y;
+    mChunks.reset();
 
-    // Set tile dimsensions
-    mCollisionBox.w = tileSideLength;
-    mCollisionBox.h = tileSideLength;
+    mWidth = widthInTiles;
+    mHeight = heightInTiles;
 
-    // Set the type
-    mType = type;
-}
+    mOwnedTypes.assign(static_cast<size_t>(widthInTiles) * heightInTiles, fill);
 
-tileType Tile::getType() const { return mType; }
+    // Round up to a whole number of 64 bit words
+    mOwnedWallBits.resize(MapFormat::getWallBitsWordCount(MapFormat::getBorderedTileCount(widthInTiles, heightInTiles)));
+    MapFormat::buildWallBits(mOwnedTypes.data(), widthInTiles, heightInTiles, mOwnedWallBits.data());
 
-// Get the collision box
-const SDL_Rect* Tile::getCollisionBox() const { return &mCollisionBox; }
+    mTypes = mOwnedTypes.data();
+    mWallBits = mOwnedWallBits.data();
+}
 
-Map::Map(SDL_Renderer* defaultRenderer) : mTileTextures{ defaultRenderer, "assets/images/tilemap.png" }
-{  
-    // Open the map
-    std::ifstream tileMapFile{ "assets/tilemap.map" };
+void TileGrid::view(int widthInTiles, int heightInTiles, Uint8* types, Uint64* wallBits)
+{
+    mChunks.reset();
 
-    // If the map couldn't be loaded
-    if (tileMapFile.is_open() == false)
-    {
-        fprintf(stderr, "Unable to load map file!\n");
-        exit(-1);
-    }
+    mWidth = widthInTiles;
+    mHeight = heightInTiles;
 
-    // Read in and store tilemap dimensions
-    loadMapVariables(tileMapFile);
+    // Release any owned storage
+    mOwnedTypes = std::vector<Uint8>{};
+    mOwnedWallBits = std::vector<Uint64>{};
 
-    // Create appropriately sized grid
-    mTiles.assign(MAP_HEIGHT_IN_TILES, std::vector<Tile>(MAP_WIDTH_IN_TILES));
+    mTypes = types;
+    mWallBits = wallBits;
+}
 
-    // Set the tiles
-    for (int iRow = 0; iRow < MAP_HEIGHT_IN_TILES; ++iRow)
-    {
-        for (int iCol = 0; iCol < MAP_WIDTH_IN_TILES; ++iCol)
-        {
-            int readInTileType = -1;
+void TileGrid::stream(int widthInTiles, int heightInTiles, const Uint8* mapData, std::size_t mapSize, std::size_t memoryBudget)
+{
+    clear();
 
-            // Read tile type from file
-            tileMapFile >> readInTileType;
+    mWidth = widthInTiles;
+    mHeight = heightInTiles;
+    mChunks = std::make_unique<ChunkCache>(mapData, mapSize, memoryBudget);
+}
 
-            // Check if read-in was successfull
-            if (tileMapFile.good() == false)
-            {
-                fprintf(stderr, "Failed to load map: read-in unsuccesful\n");
-                exit(-1);
-            }
+void TileGrid::clear()
+{
+    // Stop the loader before anything it reads from goes away
+    mChunks.reset();
 
-            // Invalid tile type
-            if (readInTileType <= -1 && readInTileType >= TOTAL_TILE_TYPES)
-            {
-                fprintf(stderr, "Failed to load map: invalid tile type\n");
-                exit(-1);
-            }
-            mTiles[iRow][iCol].setTile(iCol * TILE_SIDE_LENGTH, iRow * TILE_SIDE_LENGTH, TILE_SIDE_LENGTH, static_cast<tileType>(readInTileType));
-        }
-    }
-    // Close file
-    tileMapFile.close();
+    mWidth = 0;
+    mHeight = 0;
+    mOwnedTypes = std::vector<Uint8>{};
+    mOwnedWallBits = std::vector<Uint64>{};
+    mTypes = nullptr;
+    mWallBits = nullptr;
+}
+
+Map::Map(SDL_Renderer* defaultRenderer, const std::string& mapPath, bool allowStreaming) : mTileTextures{ defaultRenderer, "assets/images/tilemap.png" }, mRenderer{ defaultRenderer }
+{  
+    if (loadMap(mapPath, allowStreaming) == false)
+        exit(-1);
     
     loadSprites();
+    setupTileLayer();
+
+    // Streamed maps are too large for a distance field or wall shapes
+    if (!mTiles.isStreamed())
+    {
+        buildDistanceField();
+        buildWallShapes();
+    }
+}
+
+Map::~Map()
+{
+    // The grid may be streaming from the map file, release it before the file is unmapped
+    mTiles.clear();
+}
+
+bool Map::loadMap(const std::string& mapPath, bool allowStreaming)
+{
+    // Binary maps start with a header, anything else is treated as a text map
+    if (mMapFile.open(mapPath) && MapFormat::getHeader(mMapFile.getData(), mMapFile.getSize()) != nullptr)
+        return loadBinaryMap(allowStreaming);
+
+    mMapFile.close();
+    return loadTextMap(mapPath);
 }
 
-bool Map::loadMapVariables(std::ifstream& tileMapFile)
+bool Map::loadBinaryMap(bool allowStreaming)
 {
-    // Get tilemap dimensions
-    int tileScale = 0;
-    int mapWidthInTiles = 0;
-    int mapHeightInTiles = 0;
+    const MapFormat::Header& header = *MapFormat::getHeader(mMapFile.getData(), mMapFile.getSize());
+    setMapVariables(static_cast<int>(header.mTileSideLength), static_cast<int>(header.mWidthInTiles), static_cast<int>(header.mHeightInTiles));
+
+    // Compressed maps are streamed in chunks, the file stays mapped for the chunk loader
+    if ((header.mFlags & MapFormat::FLAG_CHUNK_COMPRESSED) && allowStreaming)
+    {
+        mTiles.stream(MAP_WIDTH_IN_TILES, MAP_HEIGHT_IN_TILES, mMapFile.getData(), mMapFile.getSize(), CHUNK_MEMORY_BUDGET);
+        return true;
+    }
 
-    // Quick way to check every read-in
-    auto check = [&tileMapFile]() 
+    // Otherwise every chunk is decoded up front into a grid held in memory, the file isn't needed after that
+    if (header.mFlags & MapFormat::FLAG_CHUNK_COMPRESSED)
     {
-        if (tileMapFile.good() == false)
+        std::vector<Uint8> tiles(static_cast<std::size_t>(TOTAL_TILES));
+        if (!MapFormat::decompressTiles(mMapFile.getData(), mMapFile.getSize(), tiles.data()))
         {
-            fprintf(stderr, "Failed to load map: read-in unsuccesful\n");
+            fprintf(stderr, "Failed to load map: a chunk is corrupt\n");
             return false;
         }
+        mMapFile.close();
+
+        mTiles.assign(MAP_WIDTH_IN_TILES, MAP_HEIGHT_IN_TILES, MISC_TILE);
+        for (int index = 0; index < TOTAL_TILES; ++index)
+            mTiles.setType(index, static_cast<tileType>(tiles[index]));
         return true;
-    };
+    }
 
-    tileMapFile.ignore(LONG_MAX, ' ');    // skip everything up to and including space
-    tileMapFile >> tileScale;
-    if (check() == false)                 // Check if read-in was successful
+    // Packed maps are used in place, so the tiles are checked up front rather than as they're read
+    if (!MapFormat::checkPackedTiles(mMapFile.getData(), header))
+    {
+        fprintf(stderr, "Failed to load map: the tiles or wall bitmap are corrupt\n");
         return false;
-    tileMapFile.ignore(1, '\n');          // Move on to next line
+    }
 
-    tileMapFile.ignore(LONG_MAX, ' ');
-    tileMapFile >> mapWidthInTiles;
-    if (check() == false)   
-        return false;
-    tileMapFile.ignore(1, '\n');
+    Uint8* tiles = mMapFile.getData() + MapFormat::getTilesOffset();
+    Uint64* wallBits = reinterpret_cast<Uint64*>(mMapFile.getData() + MapFormat::getWallBitsOffset(header));
+    mTiles.view(MAP_WIDTH_IN_TILES, MAP_HEIGHT_IN_TILES, tiles, wallBits);
+
+    return true;
+}
 
-    tileMapFile.ignore(LONG_MAX, ' ');
-    tileMapFile >> mapHeightInTiles;
-    if (check() == false)
+bool Map::loadTextMap(const std::string& mapPath)
+{
+    MapFormat::MapData map;
+    if (MapFormat::readTextMap(mapPath, map) == false)
         return false;
-    tileMapFile.ignore(1, '\n');
 
+    setMapVariables(map.mTileSideLength, map.mWidthInTiles, map.mHeightInTiles);
+
+    // Create appropriately sized grid and set the tiles
+    mTiles.assign(MAP_WIDTH_IN_TILES, MAP_HEIGHT_IN_TILES, MISC_TILE);
+    for (int index = 0; index < TOTAL_TILES; ++index)
+        mTiles.setType(index, static_cast<tileType>(map.mTiles[index]));
+
+    return true;
+}
+
+void Map::setMapVariables(int tileScale, int mapWidthInTiles, int mapHeightInTiles)
+{
     // Set variables
     TILE_SIDE_LENGTH = tileScale;
     MAP_WIDTH_IN_TILES = mapWidthInTiles;
@@ -129,8 +197,6 @@ bool Map::loadMapVariables(std::ifstream& tileMapFile)
     TOTAL_TILES = mapWidthInTiles * mapHeightInTiles;
     MAP_WIDTH = static_cast<float>(mapWidthInTiles * tileScale);
     MAP_HEIGHT = static_cast<float>(mapHeightInTiles * tileScale);
-
-    return true;
 }
 
 bool Map::loadSprites()
@@ -154,114 +220,653 @@ bool Map::loadSprites()
     return true;
 }
 
+void Map::setupTileLayer()
+{
+    // Chunks are as large as possible while keeping their textures a safe size
+    mTileLayerChunkSideLength = std::max(TILE_LAYER_CHUNK_PIXELS / TILE_SIDE_LENGTH, 1);
+    mTileLayerChunksPerRow = (MAP_WIDTH_IN_TILES + mTileLayerChunkSideLength - 1) / mTileLayerChunkSideLength;
 
-std::vector<SDL_Rect> Map::mergeTiles(const std::vector<const SDL_Rect*>& collidedTiles) const
+    // Fall back to batched tiles if textures can't be rendered to
+    setTileRenderMode(CACHED_TILE_LAYER);
+}
+
+void Map::buildDistanceField()
 {
-    std::vector<SDL_Rect> mergedCollisions;
+    // Use as many samples per tile as fit in the budget, maps too large for even 1 per tile search the tiles instead
+    int cellsPerTile = DISTANCE_FIELD_CELLS_PER_TILE;
+    auto getSampleCount = [this](int cells) { return (static_cast<size_t>(MAP_WIDTH_IN_TILES) * cells + 1) * (static_cast<size_t>(MAP_HEIGHT_IN_TILES) * cells + 1); };
+
+    while (cellsPerTile > 1 && getSampleCount(cellsPerTile) > MAX_DISTANCE_FIELD_SAMPLES)
+        cellsPerTile /= 2;
+
+    if (getSampleCount(cellsPerTile) > MAX_DISTANCE_FIELD_SAMPLES)
+        return;
+
+    mFieldWidth = MAP_WIDTH_IN_TILES * cellsPerTile + 1;
+    mFieldHeight = MAP_HEIGHT_IN_TILES * cellsPerTile + 1;
+    mFieldCellSize = static_cast<float>(TILE_SIDE_LENGTH) / cellsPerTile;
+
+    // Interpolating between samples can be off by at most the distance to the furthest sample, from the centre of a cell
+    mFieldError = mFieldCellSize * static_cast<float>(M_SQRT1_2);
+
+    // Samples sit on the corners of the cells, every tile corner is a sample
+    // The closest point of a wall to a sample is then always a sample too, so measuring between samples is exact
+    std::vector<float> wallDistance(static_cast<size_t>(mFieldWidth) * mFieldHeight);
+    std::vector<float> floorDistance(wallDistance.size());
 
-    // Two adjacent tiles or empty corner case
-    if (collidedTiles.size() == 2)
+    for (int iRow = 0; iRow < mFieldHeight; ++iRow)
     {
-        // Adjacent on the y axis (row)
-        if (collidedTiles[0]->y == collidedTiles[1]->y)
-            mergedCollisions.push_back(SDL_Rect{ collidedTiles[0]->x, collidedTiles[0]->y, 2 * collidedTiles[0]->w, collidedTiles[0]->h });
-        
-        // Adjacent on the x axis (column)
-        else if (collidedTiles[0]->x == collidedTiles[1]->x)
-            mergedCollisions.push_back(SDL_Rect{ collidedTiles[0]->x, collidedTiles[0]->y, collidedTiles[0]->w, 2 * collidedTiles[0]->h });
+        for (int iCol = 0; iCol < mFieldWidth; ++iCol)
+        {
+            // Check the tiles touching the sample
+            bool touchesWall = false, touchesFloor = false;
+            for (int tileRow = std::max((iRow - 1) / cellsPerTile, 0); tileRow <= std::min(iRow / cellsPerTile, MAP_HEIGHT_IN_TILES - 1); ++tileRow)
+            {
+                for (int tileCol = std::max((iCol - 1) / cellsPerTile, 0); tileCol <= std::min(iCol / cellsPerTile, MAP_WIDTH_IN_TILES - 1); ++tileCol)
+                {
+                    if (mTiles.isWall(tileRow, tileCol))
+                        touchesWall = true;
+                    else
+                        touchesFloor = true;
+                }
+            }
+
+            size_t index = static_cast<size_t>(iRow) * mFieldWidth + iCol;
+            wallDistance[index] = touchesWall ? 0.f : DISTANCE_FIELD_FAR;
+            floorDistance[index] = touchesFloor ? 0.f : DISTANCE_FIELD_FAR;
+        }
     }
-    if (mergedCollisions.size() == 0)
+
+    transformDistances(wallDistance);
+    transformDistances(floorDistance);
+
+    // Positive outside walls, negative inside
+    mDistanceField.resize(wallDistance.size());
+    for (size_t i = 0; i < mDistanceField.size(); ++i)
+        mDistanceField[i] = (wallDistance[i] > 0.f ? sqrtf(wallDistance[i]) : -sqrtf(floorDistance[i])) * mFieldCellSize;
+}
+
+// Felzenszwalb, Pedro F. and Huttenlocher, Daniel P. (2012). "Distance Transforms of Sampled Functions"
+// Finds the squared distance to the nearest 0 along every column, then along every row using the column results
+// Each line is solved in linear time using the lower envelope of the parabolas rooted at its samples
+void Map::transformDistances(std::vector<float>& distances) const
+{
+    int longestLine = std::max(mFieldWidth, mFieldHeight);
+    std::vector<float> line(longestLine);
+    std::vector<float> result(longestLine);
+    std::vector<int> roots(longestLine);            // Samples whose parabolas make up the envelope
+    std::vector<float> bounds(longestLine + 1);     // Where each parabola of the envelope starts
+
+    auto transformLine = [&](int length)
+    {
+        int parabola = 0;
+        roots[0] = 0;
+        bounds[0] = -std::numeric_limits<float>::infinity();
+        bounds[1] = std::numeric_limits<float>::infinity();
+
+        for (int q = 1; q < length; ++q)
+        {
+            // Intersection of the parabola rooted at q with the last one in the envelope, hidden parabolas are dropped
+            float intersection;
+            while (true)
+            {
+                int root = roots[parabola];
+                intersection = ((line[q] + static_cast<float>(q * q)) - (line[root] + static_cast<float>(root * root))) / static_cast<float>(2 * (q - root));
+                if (intersection > bounds[parabola] || parabola == 0)
+                    break;
+                --parabola;
+            }
+
+            ++parabola;
+            roots[parabola] = q;
+            bounds[parabola] = intersection;
+            bounds[parabola + 1] = std::numeric_limits<float>::infinity();
+        }
+
+        parabola = 0;
+        for (int q = 0; q < length; ++q)
+        {
+            while (bounds[parabola + 1] < static_cast<float>(q))
+                ++parabola;
+
+            int root = roots[parabola];
+            result[q] = static_cast<float>((q - root) * (q - root)) + line[root];
+        }
+    };
+
+    for (int iCol = 0; iCol < mFieldWidth; ++iCol)
     {
-        for (auto& collidedTile : collidedTiles)
-            mergedCollisions.push_back(*collidedTile);
+        for (int iRow = 0; iRow < mFieldHeight; ++iRow)
+            line[iRow] = distances[static_cast<size_t>(iRow) * mFieldWidth + iCol];
+
+        transformLine(mFieldHeight);
+
+        for (int iRow = 0; iRow < mFieldHeight; ++iRow)
+            distances[static_cast<size_t>(iRow) * mFieldWidth + iCol] = result[iRow];
+    }
+
+    for (int iRow = 0; iRow < mFieldHeight; ++iRow)
+    {
+        float* row = &distances[static_cast<size_t>(iRow) * mFieldWidth];
+        std::copy(row, row + mFieldWidth, line.begin());
+
+        transformLine(mFieldWidth);
+
+        std::copy(result.begin(), result.begin() + mFieldWidth, row);
     }
-    return mergedCollisions;
 }
 
-// Check wall collisions
-bool Map::checkWallCollisions(const SDL_FRect& box, Vec& adjustPos)
+void Map::buildWallShapes()
 {
-    // Grab all unique tiles that the entity is on
-    // by checking if each corner of the hitbox is on a different tile
+    mWallOutlines = WallGeometry::traceOutlines(mTiles, TILE_SIDE_LENGTH);
+    mWallShapes = WallGeometry::decompose(mWallOutlines);
 
-    std::vector<const SDL_Rect*> collidedTileBoxes;
-    Vec entityBoxCorner{0,0};
-    
-    // Use a lambda to verify and add a corner that lies on a wall tile not already added to the list
-    auto verifyAndAdd = [this, &collidedTileBoxes, &entityBoxCorner]()
-    { 
-        Tile* tempCollidedTile = getTileFromWorldPoint(entityBoxCorner);
-        const SDL_Rect* tempCollidedBox;
-
-        // Proceed only if it's a wall tile
-        if (tempCollidedTile->getType() == WALL_TILE)
-            tempCollidedBox = tempCollidedTile->getCollisionBox();
-        else
-            return;
+    mWallShapeBounds.clear();
+    mWallShapeBounds.reserve(mWallShapes.size());
+    for (auto& shape : mWallShapes)
+    {
+        // The shapes are rectangles, opposite corners give the bounds
+        const Vec& topLeft = shape.getVertices()[0];
+        const Vec& bottomRight = shape.getVertices()[2];
+        mWallShapeBounds.push_back(SDL_FRect{ topLeft.getX(), topLeft.getY(), bottomRight.getX() - topLeft.getX(), bottomRight.getY() - topLeft.getY() });
+    }
+}
 
-        // Check if this collision box is already present before adding it to the list
-        if (find(collidedTileBoxes.begin(), collidedTileBoxes.end(), tempCollidedBox) == collidedTileBoxes.end())
-            collidedTileBoxes.push_back(tempCollidedBox);
+Vec Map::resolveWallCollisions(const ConvexPolygon& shape) const
+{
+    // Bounding box of the shape
+    float minX = std::numeric_limits<float>::infinity(), minY = minX;
+    float maxX = -minX, maxY = -minX;
+    for (auto& vertex : shape.getVertices())
+    {
+        minX = std::min(minX, vertex.getX());
+        minY = std::min(minY, vertex.getY());
+        maxX = std::max(maxX, vertex.getX());
+        maxY = std::max(maxY, vertex.getY());
+    }
+    SDL_FRect bounds{ minX, minY, maxX - minX, maxY - minY };
 
-        return; 
-    };
+    Vec totalSolution{ 0.f, 0.f };
+    for (size_t iShape = 0; iShape < mWallShapes.size(); ++iShape)
+    {
+        // Only run the separating axis test on walls the shape might overlap
+        if (!checkCollision(bounds, mWallShapeBounds[iShape]))
+            continue;
+
+        ConvexPolygon::addToSolution(ConvexPolygon::resolveCollision(shape, mWallShapes[iShape]), totalSolution);
+    }
+
+    return totalSolution;
+}
+
+bool Map::castRay(const Vec& start, const Vec& dest, float& time) const
+{
+    Vec direction{ dest - start };
+    time = 1.f;
+    bool hit = false;
+
+    for (auto& bounds : mWallShapeBounds)
+    {
+        // Slab test, the ray is inside the box between the last entry and the first exit over both axes
+        float entry = 0.f;
+        float exit = time;
+        float origins[2] = { start.getX(), start.getY() };
+        float deltas[2] = { direction.getX(), direction.getY() };
+        float mins[2] = { bounds.x, bounds.y };
+        float maxes[2] = { bounds.x + bounds.w, bounds.y + bounds.h };
+
+        for (int axis = 0; axis < 2 && entry <= exit; ++axis)
+        {
+            if (deltas[axis] == 0.f)
+            {
+                // Parallel to the slab, either always or never inside it
+                if (origins[axis] < mins[axis] || origins[axis] > maxes[axis])
+                    entry = std::numeric_limits<float>::infinity();
+                continue;
+            }
+
+            float t0 = (mins[axis] - origins[axis]) / deltas[axis];
+            float t1 = (maxes[axis] - origins[axis]) / deltas[axis];
+            entry = std::max(entry, std::min(t0, t1));
+            exit = std::min(exit, std::max(t0, t1));
+        }
+
+        if (entry <= exit)
+        {
+            time = entry;
+            hit = true;
+        }
+    }
+
+    return hit;
+}
+
+SDL_Rect Map::getTileBox(int index) const
+{
+    return SDL_Rect{ mTiles.getCol(index) * TILE_SIDE_LENGTH, mTiles.getRow(index) * TILE_SIDE_LENGTH, TILE_SIDE_LENGTH, TILE_SIDE_LENGTH };
+}
+
+Vec Map::getTileCentre(int index) const
+{
+    return Vec{ (static_cast<float>(mTiles.getCol(index)) + 0.5f) * TILE_SIDE_LENGTH, (static_cast<float>(mTiles.getRow(index)) + 0.5f) * TILE_SIDE_LENGTH };
+}
+
+float Map::getDistanceToTile(const Vec& point, int tileIndex) const
+{
+    float left = static_cast<float>(mTiles.getCol(tileIndex) * TILE_SIDE_LENGTH);
+    float top = static_cast<float>(mTiles.getRow(tileIndex) * TILE_SIDE_LENGTH);
+
+    // Distance on each axis, 0 if the point is within the tile's span on that axis
+    float deltaX = std::max({ left - point.getX(), 0.f, point.getX() - (left + TILE_SIDE_LENGTH) });
+    float deltaY = std::max({ top - point.getY(), 0.f, point.getY() - (top + TILE_SIDE_LENGTH) });
+
+    return sqrtf(deltaX * deltaX + deltaY * deltaY);
+}
+
+float Map::distanceToWall(const Vec& point) const
+{
+    // The map's edges act as walls, negative outside of the map
+    float edgeDistance = std::min({ point.getX(), point.getY(), MAP_WIDTH - point.getX(), MAP_HEIGHT - point.getY() });
+
+    if (mDistanceField.empty())
+        return std::min(edgeDistance, getClearance(point));
+
+    // Position in cells, clamped to the field
+    float x = std::clamp(point.getX() / mFieldCellSize, 0.f, static_cast<float>(mFieldWidth - 1));
+    float y = std::clamp(point.getY() / mFieldCellSize, 0.f, static_cast<float>(mFieldHeight - 1));
+    int col = std::min(static_cast<int>(x), mFieldWidth - 2);
+    int row = std::min(static_cast<int>(y), mFieldHeight - 2);
+    float u = x - col;
+    float v = y - row;
+
+    // Bilinear interpolation between the cell's corners
+    const float* top = &mDistanceField[static_cast<size_t>(row) * mFieldWidth + col];
+    const float* bottom = top + mFieldWidth;
+    float distance = (top[0] * (1.f - u) + top[1] * u) * (1.f - v) + (bottom[0] * (1.f - u) + bottom[1] * u) * v;
+
+    return std::min(edgeDistance, distance);
+}
+
+Vec Map::getWallGradient(const Vec& point) const
+{
+    // Central differences a cell apart
+    float step = mDistanceField.empty() ? static_cast<float>(TILE_SIDE_LENGTH) / 4.f : mFieldCellSize;
+
+    Vec gradient{ distanceToWall(point + Vec{ step, 0.f }) - distanceToWall(point - Vec{ step, 0.f }),
+        distanceToWall(point + Vec{ 0.f, step }) - distanceToWall(point - Vec{ 0.f, step }) };
+
+    if (!gradient.isZeroVector())
+        gradient.normalize();
+
+    return gradient;
+}
+
+bool Map::traceCircle(const Vec& start, const Vec& dest, float radius, float& time) const
+{
+    Vec direction{ dest - start };
+    float length = direction.getMagnitude();
+
+    if (length > 0.f)
+        direction /= length;
+
+    // Sphere tracing, no wall is closer than the distance to the nearest wall so the circle can safely move that far
+    // The interpolation error is taken off of every distance so the circle never steps into a wall
+    float travelled = 0.f;
+    while (true)
+    {
+        float gap = distanceToWall(start + direction * travelled) - mFieldError - radius;
+
+        if (gap < SPHERE_TRACE_EPSILON)
+        {
+            time = length > 0.f ? travelled / length : 0.f;
+            return true;
+        }
+
+        if (travelled >= length)
+            break;
+
+        travelled = std::min(travelled + gap, length);
+    }
+
+    time = 1.f;
+    return false;
+}
+
+float Map::getClearance(const Vec& point) const
+{
+    // Points outside of the map have no clearance
+    if (point.getX() < 0.f || point.getX() >= MAP_WIDTH || point.getY() < 0.f || point.getY() >= MAP_HEIGHT)
+        return 0.f;
+
+    if (!mDistanceField.empty())
+        return std::max(distanceToWall(point), 0.f);
+
+    int col = static_cast<int>(point.getX()) / TILE_SIDE_LENGTH;
+    int row = static_cast<int>(point.getY()) / TILE_SIDE_LENGTH;
+
+    if (mTiles.isWall(row, col))
+        return 0.f;
+
+    // The map's edges act as walls
+    float clearance = std::min({ point.getX(), point.getY(), MAP_WIDTH - point.getX(), MAP_HEIGHT - point.getY() });
+
+    return std::min(clearance, getNearbyWallDistance(point, row, col));
+}
+
+float Map::getNearbyWallDistance(const Vec& point, int row, int col) const
+{
+    // Walls outside of the searched square are atleast as far as its edges
+    float searchLeft = static_cast<float>((col - CLEARANCE_SEARCH_RADIUS) * TILE_SIDE_LENGTH);
+    float searchTop = static_cast<float>((row - CLEARANCE_SEARCH_RADIUS) * TILE_SIDE_LENGTH);
+    float searchSide = static_cast<float>((2 * CLEARANCE_SEARCH_RADIUS + 1) * TILE_SIDE_LENGTH);
+
+    float distance = std::min({ point.getX() - searchLeft, point.getY() - searchTop, searchLeft + searchSide - point.getX(), searchTop + searchSide - point.getY() });
+
+    // Search outwards in square rings around the point's tile
+    for (int ring = 1; ring <= CLEARANCE_SEARCH_RADIUS; ++ring)
+    {
+        // Every tile in this ring is atleast (ring - 1) tiles away
+        if (distance <= static_cast<float>((ring - 1) * TILE_SIDE_LENGTH))
+            break;
+
+        for (int iRow = std::max(row - ring, 0); iRow <= std::min(row + ring, MAP_HEIGHT_IN_TILES - 1); ++iRow)
+        {
+            // Only the first and last rows are fully on the ring
+            int colStep = (iRow == row - ring || iRow == row + ring) ? 1 : 2 * ring;
+
+            for (int iCol = col - ring; iCol <= col + ring; iCol += colStep)
+            {
+                if (iCol < 0 || iCol >= MAP_WIDTH_IN_TILES || !mTiles.isWall(iRow, iCol))
+                    continue;
+
+                distance = std::min(distance, getDistanceToTile(point, mTiles.getIndex(iRow, iCol)));
+            }
+        }
+    }
+    return distance;
+}
 
-    // Must be in row major order
-    // 1st corner
-    entityBoxCorner = Vec{box.x, box.y};
-    verifyAndAdd();
+float Map::getClearance(const Vec& start, const Vec& dest, float minClearance) const
+{
+    Vec direction{ dest - start };
+    float length = direction.getMagnitude();
 
-    // 2nd corner
-    entityBoxCorner += Vec{ box.w, 0.f };
-    verifyAndAdd();
+    float currentClearance = getClearance(start);
+    float smallestClearance = currentClearance;
 
-    // 3nd corner
-    entityBoxCorner += Vec{ -box.w, box.h };
-    verifyAndAdd();
+    if (length == 0.f)
+        return smallestClearance;
 
-    // 4th corner
-    entityBoxCorner += Vec{ box.w, 0 };
-    verifyAndAdd();
+    direction /= length;
 
-    // If any corner is in a wall tile, resolve the collision
-    if (collidedTileBoxes.size() > 0)
+    // March along the line, every point within (current - smallest) of the current point
+    // is at least as clear as the smallest clearance so far, so those points can be skipped
+    float travelled = 0.f;
+    while (travelled < length && smallestClearance >= minClearance)
     {
-        // If possible, merge the collided tiles to all for sliding against walls
-        buildCollisionReport(box, mergeTiles(collidedTileBoxes), adjustPos);
+        travelled = std::min(travelled + std::max(currentClearance - smallestClearance, TRACE_STEP), length);
+
+        currentClearance = getClearance(start + direction * travelled);
+        smallestClearance = std::min(smallestClearance, currentClearance);
+    }
+
+    // A fixed size step can skip over a dip of at most half a step
+    return smallestClearance - TRACE_STEP / 2.f;
+}
+
+bool Map::hasLineOfSight(const Vec& start, const Vec& dest, float agentRadius) const
+{
+    float time;
+    return !traceCircle(start, dest, agentRadius, time);
+}
+
+// Check wall collisions
+bool Map::checkWallCollisions(const SDL_FRect& box, Vec& adjustPos)
+{
+    // Every tile under the box, edges that only touch a tile don't count
+    int firstCol = std::max(static_cast<int>(floorf(box.x / TILE_SIDE_LENGTH)), 0);
+    int firstRow = std::max(static_cast<int>(floorf(box.y / TILE_SIDE_LENGTH)), 0);
+    int lastCol = std::min(static_cast<int>(ceilf((box.x + box.w) / TILE_SIDE_LENGTH)) - 1, MAP_WIDTH_IN_TILES - 1);
+    int lastRow = std::min(static_cast<int>(ceilf((box.y + box.h) / TILE_SIDE_LENGTH)) - 1, MAP_HEIGHT_IN_TILES - 1);
+
+    // Checks if a row under the box has a run of walls spanning exactly the given columns
+    auto isSameRun = [this, firstCol, lastCol](int row, int runFirstCol, int runLastCol)
+    {
+        if (runFirstCol > firstCol && mTiles.isWall(row, runFirstCol - 1))
+            return false;
+        if (runLastCol < lastCol && mTiles.isWall(row, runLastCol + 1))
+            return false;
+
+        for (int iCol = runFirstCol; iCol <= runLastCol; ++iCol)
+        {
+            if (!mTiles.isWall(row, iCol))
+                return false;
+        }
         return true;
+    };
+
+    bool collided = false;
+
+    // Merge the walls into as few boxes as possible to allow for sliding against walls
+    // Each box is added to the report as soon as it's found, so nothing needs to be stored
+    for (int iRow = firstRow; iRow <= lastRow; ++iRow)
+    {
+        for (int iCol = firstCol; iCol <= lastCol; ++iCol)
+        {
+            if (!mTiles.isWall(iRow, iCol))
+                continue;
+
+            // Find the end of the horizontal run of walls
+            int runLastCol = iCol;
+            while (runLastCol < lastCol && mTiles.isWall(iRow, runLastCol + 1))
+                ++runLastCol;
+
+            // Runs that carry on from the row above are already part of that row's box
+            if (iRow == firstRow || !isSameRun(iRow - 1, iCol, runLastCol))
+            {
+                // Extend the box down over the rows with the same run
+                int runLastRow = iRow;
+                while (runLastRow < lastRow && isSameRun(runLastRow + 1, iCol, runLastCol))
+                    ++runLastRow;
+
+                SDL_Rect wallBox{ iCol * TILE_SIDE_LENGTH, iRow * TILE_SIDE_LENGTH, (runLastCol - iCol + 1) * TILE_SIDE_LENGTH, (runLastRow - iRow + 1) * TILE_SIDE_LENGTH };
+                addToCollisionReport(box, wallBox, adjustPos);
+                collided = true;
+            }
+
+            iCol = runLastCol;
+        }
     }
-    else
+
+    return collided;
+}
+
+bool Map::sweepBox(const SDL_FRect& box, const Vec& displacement, float& time, Vec& normal) const
+{
+    time = 1.f;
+    normal = Vec{ 0.f, 0.f };
+
+    if (displacement.isZeroVector())
         return false;
+
+    // Only the tiles covered by the box along the way can be hit
+    float sweptLeft = box.x + std::min(displacement.getX(), 0.f);
+    float sweptTop = box.y + std::min(displacement.getY(), 0.f);
+    float sweptRight = box.x + box.w + std::max(displacement.getX(), 0.f);
+    float sweptBottom = box.y + box.h + std::max(displacement.getY(), 0.f);
+
+    int firstCol = std::max(static_cast<int>(floorf(sweptLeft / TILE_SIDE_LENGTH)), 0);
+    int firstRow = std::max(static_cast<int>(floorf(sweptTop / TILE_SIDE_LENGTH)), 0);
+    int lastCol = std::min(static_cast<int>(floorf(sweptRight / TILE_SIDE_LENGTH)), MAP_WIDTH_IN_TILES - 1);
+    int lastRow = std::min(static_cast<int>(floorf(sweptBottom / TILE_SIDE_LENGTH)), MAP_HEIGHT_IN_TILES - 1);
+
+    bool hit = false;
+
+    for (int iRow = firstRow; iRow <= lastRow; ++iRow)
+    {
+        for (int iCol = firstCol; iCol <= lastCol; ++iCol)
+        {
+            if (!mTiles.isWall(iRow, iCol))
+                continue;
+
+            float tileLeft = static_cast<float>(iCol * TILE_SIDE_LENGTH);
+            float tileTop = static_cast<float>(iRow * TILE_SIDE_LENGTH);
+            float tileRight = tileLeft + TILE_SIDE_LENGTH;
+            float tileBottom = tileTop + TILE_SIDE_LENGTH;
+
+            // Times at which the box starts and stops overlapping the tile on each axis
+            float entryX, exitX, entryY, exitY;
+
+            if (displacement.getX() > 0.f)
+            {
+                entryX = (tileLeft - (box.x + box.w)) / displacement.getX();
+                exitX = (tileRight - box.x) / displacement.getX();
+            }
+            else if (displacement.getX() < 0.f)
+            {
+                entryX = (tileRight - box.x) / displacement.getX();
+                exitX = (tileLeft - (box.x + box.w)) / displacement.getX();
+            }
+            // Not moving on this axis, must already overlap on it
+            else if (box.x < tileRight && box.x + box.w > tileLeft)
+            {
+                entryX = -std::numeric_limits<float>::infinity();
+                exitX = std::numeric_limits<float>::infinity();
+            }
+            else
+                continue;
+
+            if (displacement.getY() > 0.f)
+            {
+                entryY = (tileTop - (box.y + box.h)) / displacement.getY();
+                exitY = (tileBottom - box.y) / displacement.getY();
+            }
+            else if (displacement.getY() < 0.f)
+            {
+                entryY = (tileBottom - box.y) / displacement.getY();
+                exitY = (tileTop - (box.y + box.h)) / displacement.getY();
+            }
+            else if (box.y < tileBottom && box.y + box.h > tileTop)
+            {
+                entryY = -std::numeric_limits<float>::infinity();
+                exitY = std::numeric_limits<float>::infinity();
+            }
+            else
+                continue;
+
+            float entry = std::max(entryX, entryY);
+            float exit = std::min(exitX, exitY);
+
+            // Missed, already overlapping (left to the overlap resolution), or hit later than a closer tile
+            if (entry >= exit || entry < 0.f || entry >= time)
+                continue;
+
+            // The axis that started overlapping last is the one that was hit
+            bool hitX = entryX > entryY;
+
+            // Faces shared with another wall tile can't be hit, it's a seam between tiles the box is sliding over
+            int neighbourCol = iCol - (displacement.getX() > 0.f ? 1 : -1);
+            int neighbourRow = iRow - (displacement.getY() > 0.f ? 1 : -1);
+            if (hitX && displacement.getY() != 0.f && neighbourCol >= 0 && neighbourCol < MAP_WIDTH_IN_TILES && mTiles.isWall(iRow, neighbourCol))
+                hitX = false;
+            else if (!hitX && displacement.getX() != 0.f && neighbourRow >= 0 && neighbourRow < MAP_HEIGHT_IN_TILES && mTiles.isWall(neighbourRow, iCol))
+                hitX = true;
+
+            time = entry;
+            normal = hitX ? Vec{ displacement.getX() > 0.f ? -1.f : 1.f, 0.f } : Vec{ 0.f, displacement.getY() > 0.f ? -1.f : 1.f };
+            hit = true;
+        }
+    }
+    return hit;
 }
 
-// Returns a tile that a passed in point lies on
-Tile* Map::getTileFromWorldPoint(const Vec& point)
+Vec Map::slideBox(const SDL_FRect& box, const Vec& displacement, Vec& contactNormal) const
 {
-    // Check if point is inside map bounds
-    if (point.getX() < 0.f || point.getX() >= MAP_WIDTH || point.getY() < 0.f || point.getY() >= MAP_HEIGHT)
+    contactNormal = Vec{ 0.f, 0.f };
+
+    SDL_FRect movedBox = box;
+    Vec remaining = displacement;
+
+    for (int iSlide = 0; iSlide < MAX_SLIDES && !remaining.isZeroVector(); ++iSlide)
     {
-        fprintf(stderr, "Point is outside the map bounds\n");
-        return nullptr;
+        float time;
+        Vec normal;
+        if (!sweepBox(movedBox, remaining, time, normal))
+        {
+            movedBox.x += remaining.getX();
+            movedBox.y += remaining.getY();
+            break;
+        }
+
+        // Stop just short of the wall
+        float length = remaining.getMagnitude();
+        time = std::max(time - SWEEP_SKIN / length, 0.f);
+
+        movedBox.x += remaining.getX() * time;
+        movedBox.y += remaining.getY() * time;
+
+        // Slide along the wall with whatever is left, minus the part heading into it
+        remaining *= 1.f - time;
+        if (normal.getX() != 0.f)
+            remaining.setX(0.f);
+        else
+            remaining.setY(0.f);
+
+        contactNormal += normal;
     }
 
+    return Vec{ movedBox.x - box.x, movedBox.y - box.y };
+}
+
+// Returns the index of the tile that a passed in point lies on
+int Map::getTileFromWorldPoint(const Vec& point) const
+{
+    // Check if point is inside map bounds
     // Convert pixel coordinates to tile in 2d array
-    // E.g, 0.5 tiles is on the 0th tile
-    int col = static_cast<int>(point.getX()) / TILE_SIDE_LENGTH;
-    int row = static_cast<int>(point.getY()) / TILE_SIDE_LENGTH;
-    return &mTiles[row][col];
+    // E.g, 0.5 tiles is on the 0th tile, rounded the same way as isInWall so both agree on the tile
+    int col = static_cast<int>(floorf(point.getX() / TILE_SIDE_LENGTH));
+    int row = static_cast<int>(floorf(point.getY() / TILE_SIDE_LENGTH));
+    return mTiles.getIndex(row, col);
+}
+
+void Map::countOutOfBoundsLookup(const Vec& point) const
+{
+    if (point.getX() >= 0.f && point.getX() < MAP_WIDTH && point.getY() >= 0.f && point.getY() < MAP_HEIGHT)
+        return;
+
+    Uint32 count = ++mOutOfBoundsLookups;
+    Uint32 now = SDL_GetTicks();
+    Uint32 lastReport = mLastOutOfBoundsReport.load(std::memory_order_relaxed);
+
+    // Only the thread that claims the report prints it
+    if (now - lastReport >= OUT_OF_BOUNDS_REPORT_INTERVAL && mLastOutOfBoundsReport.compare_exchange_strong(lastReport, now))
+    {
+        count = mOutOfBoundsLookups.exchange(0);
+        fprintf(stderr, "%u points looked up outside of the map bounds\n", count);
+    }
 }
 
 // Checks if a point is inside a wall
-bool Map::isInWall(const Vec& pos)
+bool Map::isInWall(const Vec& pos) const
 {
-    Tile* tileUnderPoint = getTileFromWorldPoint(pos);
-    if (tileUnderPoint != nullptr && tileUnderPoint->getType() == WALL_TILE)
-        return true;
-    return false;
+    // Clamp the point to within a tile of the map, anything further out lands on the wall border
+    // Written so that NaN clamps as well
+    float x = std::min(std::max(-1.f, pos.getX()), MAP_WIDTH);
+    float y = std::min(std::max(-1.f, pos.getY()), MAP_HEIGHT);
+
+    int col = static_cast<int>(floorf(x / TILE_SIDE_LENGTH));
+    int row = static_cast<int>(floorf(y / TILE_SIDE_LENGTH));
+    return mTiles.isWallOrBorder(row, col);
 }
 
 void Map::render(const SDL_FRect& camera)
 {
+    // Maps loaded without a renderer (e.g, headless) have nothing to draw with
+    if (mRenderer == nullptr)
+        return;
+
+    ++mFrame;
+
     // Determine rendering bounds
     int firstRow = static_cast<int>(camera.y) / TILE_SIDE_LENGTH;
     if (firstRow < 0) firstRow = 0;
@@ -275,18 +880,254 @@ void Map::render(const SDL_FRect& camera)
     int lastCol = (static_cast<int>(camera.x) + SCREEN_WIDTH) / TILE_SIDE_LENGTH;
     if (lastCol >= MAP_WIDTH_IN_TILES) lastCol = MAP_WIDTH_IN_TILES - 1;
 
+    // Nothing of the map is visible
+    if (firstRow > lastRow || firstCol > lastCol)
+        return;
+
+    if (mRenderMode == CACHED_TILE_LAYER && drawTileLayer(camera, firstRow, firstCol, lastRow, lastCol))
+        return;
+
+    if (mRenderMode != TILE_BY_TILE && drawTilesBatched(firstRow, firstCol, lastRow, lastCol, camera.x, camera.y))
+        return;
+
+    // Batching the whole screen failed, so batching is given up on rather than retried every frame
+    if (mRenderMode == BATCHED_TILES)
+    {
+        fprintf(stderr, "Unable to batch tiles, drawing tiles individually\n");
+        mRenderMode = TILE_BY_TILE;
+    }
+
+    drawTiles(firstRow, firstCol, lastRow, lastCol, camera.x, camera.y);
+}
+
+void Map::drawTiles(int firstRow, int firstCol, int lastRow, int lastCol, float originX, float originY)
+{
     // Render the level
     // Note: <= is used to render the last visable row or col
     for (int iRow = firstRow; iRow <= lastRow; ++iRow)
     {
         for (int iCol = firstCol; iCol <= lastCol; ++iCol)
         {
-            Tile* tile = &mTiles[iRow][iCol];
-            const SDL_Rect* tileCollisionBox = tile->getCollisionBox();
+            int screenPosX = static_cast<int>(roundf(static_cast<float>(iCol * TILE_SIDE_LENGTH) - originX));
+            int screenPosY = static_cast<int>(roundf(static_cast<float>(iRow * TILE_SIDE_LENGTH) - originY));
+            mTileTextures.draw(screenPosX, screenPosY, &mTileSprites[mTiles.getType(iRow, iCol)]);
+        }
+    }
+}
 
-            int screenPosX = static_cast<int>(roundf(static_cast<float>(tileCollisionBox->x) - camera.x));
-            int screenPosY = static_cast<int>(roundf(static_cast<float>(tileCollisionBox->y) - camera.y));
-            mTileTextures.draw(screenPosX, screenPosY, &mTileSprites[tile->getType()]);
+bool Map::drawTilesBatched(int firstRow, int firstCol, int lastRow, int lastCol, float originX, float originY)
+{
+    SDL_Rect tiles{ firstCol, firstRow, lastCol - firstCol + 1, lastRow - firstRow + 1 };
+    bool rebuilt = false;
+
+    // Only look the tiles up again once the camera has crossed into different tiles
+    if (tiles.x != mBatchTiles.x || tiles.y != mBatchTiles.y || tiles.w != mBatchTiles.w || tiles.h != mBatchTiles.h)
+    {
+        buildTileBatch(tiles);
+        rebuilt = true;
+    }
+
+    // Move the quads relative to the origin, rounded the same way as individual tiles
+    if (rebuilt || originX != mBatchOrigin.x || originY != mBatchOrigin.y)
+    {
+        for (size_t iQuad = 0; iQuad < mBatchQuads.size(); ++iQuad)
+        {
+            const SDL_Rect& quad = mBatchQuads[iQuad];
+            float left = roundf(static_cast<float>(quad.x) - originX);
+            float top = roundf(static_cast<float>(quad.y) - originY);
+            float right = left + static_cast<float>(quad.w);
+            float bottom = top + static_cast<float>(quad.h);
+
+            SDL_Vertex* vertex = &mBatchVertices[iQuad * 4];
+            vertex[0].position = SDL_FPoint{ left, top };
+            vertex[1].position = SDL_FPoint{ right, top };
+            vertex[2].position = SDL_FPoint{ left, bottom };
+            vertex[3].position = SDL_FPoint{ right, bottom };
         }
+        mBatchOrigin = SDL_FPoint{ originX, originY };
     }
-}
\ No newline at end of file
+
+    // Callers decide how far to fall back, a failure here says nothing about other chunks or frames
+    return mTileTextures.drawGeometry(mBatchVertices.data(), static_cast<int>(mBatchVertices.size()), mBatchIndices.data(), static_cast<int>(mBatchQuads.size() * 6));
+}
+
+void Map::buildTileBatch(const SDL_Rect& tiles)
+{
+    mBatchTiles = tiles;
+
+    size_t quadCount = static_cast<size_t>(tiles.w) * tiles.h;
+    mBatchQuads.resize(quadCount);
+    mBatchVertices.resize(quadCount * 4);
+
+    // Indices only depend on the number of quads, so they're only ever extended
+    for (size_t iQuad = mBatchIndices.size() / 6; iQuad < quadCount; ++iQuad)
+    {
+        int first = static_cast<int>(iQuad * 4);
+        mBatchIndices.insert(mBatchIndices.end(), { first, first + 1, first + 2, first + 2, first + 1, first + 3 });
+    }
+
+    float textureWidth = static_cast<float>(mTileTextures.getWidth());
+    float textureHeight = static_cast<float>(mTileTextures.getHeight());
+    SDL_Rect textureDimensions{ 0, 0, mTileTextures.getWidth(), mTileTextures.getHeight() };
+
+    size_t iQuad = 0;
+    for (int iRow = tiles.y; iRow < tiles.y + tiles.h; ++iRow)
+    {
+        for (int iCol = tiles.x; iCol < tiles.x + tiles.w; ++iCol, ++iQuad)
+        {
+            // Sprites are cropped to the texture like Texture::draw does
+            SDL_Rect sprite{ 0, 0, 0, 0 };
+            SDL_IntersectRect(&textureDimensions, &mTileSprites[mTiles.getType(iRow, iCol)], &sprite);
+
+            mBatchQuads[iQuad] = SDL_Rect{ iCol * TILE_SIDE_LENGTH, iRow * TILE_SIDE_LENGTH, sprite.w, sprite.h };
+
+            float u0 = static_cast<float>(sprite.x) / textureWidth;
+            float v0 = static_cast<float>(sprite.y) / textureHeight;
+            float u1 = static_cast<float>(sprite.x + sprite.w) / textureWidth;
+            float v1 = static_cast<float>(sprite.y + sprite.h) / textureHeight;
+
+            SDL_Vertex* vertex = &mBatchVertices[iQuad * 4];
+            vertex[0] = SDL_Vertex{ SDL_FPoint{ 0.f, 0.f }, SDL_Color{ 255, 255, 255, 255 }, SDL_FPoint{ u0, v0 } };
+            vertex[1] = SDL_Vertex{ SDL_FPoint{ 0.f, 0.f }, SDL_Color{ 255, 255, 255, 255 }, SDL_FPoint{ u1, v0 } };
+            vertex[2] = SDL_Vertex{ SDL_FPoint{ 0.f, 0.f }, SDL_Color{ 255, 255, 255, 255 }, SDL_FPoint{ u0, v1 } };
+            vertex[3] = SDL_Vertex{ SDL_FPoint{ 0.f, 0.f }, SDL_Color{ 255, 255, 255, 255 }, SDL_FPoint{ u1, v1 } };
+        }
+    }
+}
+
+bool Map::drawTileLayer(const SDL_FRect& camera, int firstRow, int firstCol, int lastRow, int lastCol)
+{
+    int chunkPixels = mTileLayerChunkSideLength * TILE_SIDE_LENGTH;
+
+    for (int iChunkRow = firstRow / mTileLayerChunkSideLength; iChunkRow <= lastRow / mTileLayerChunkSideLength; ++iChunkRow)
+    {
+        for (int iChunkCol = firstCol / mTileLayerChunkSideLength; iChunkCol <= lastCol / mTileLayerChunkSideLength; ++iChunkCol)
+        {
+            int chunkIndex = iChunkRow * mTileLayerChunksPerRow + iChunkCol;
+            TileLayerChunk& chunk = mTileLayer[chunkIndex];
+            chunk.mLastUsedFrame = mFrame;
+
+            // Chunks are only drawn tile by tile when they're first seen or invalidated
+            if (chunk.mStale && bakeTileLayerChunk(chunkIndex, chunk) == false)
+            {
+                fprintf(stderr, "Unable to cache the tile layer, batching tiles instead\n");
+                mRenderMode = BATCHED_TILES;
+                invalidateTileLayer();
+                return false;
+            }
+
+            int width = 0, height = 0;
+            SDL_QueryTexture(chunk.mTexture.get(), nullptr, nullptr, &width, &height);
+
+            // Rounded the same way as individual tiles so both paths line up
+            SDL_Rect renderArea{ static_cast<int>(roundf(static_cast<float>(iChunkCol * chunkPixels) - camera.x)), static_cast<int>(roundf(static_cast<float>(iChunkRow * chunkPixels) - camera.y)), width, height };
+
+            if (SDL_RenderCopy(mRenderer, chunk.mTexture.get(), nullptr, &renderArea) != 0)
+                fprintf(stderr, "%s", SDL_GetError());
+        }
+    }
+
+    evictTileLayerChunks();
+    return true;
+}
+
+bool Map::bakeTileLayerChunk(int chunkIndex, TileLayerChunk& chunk)
+{
+    int firstRow = (chunkIndex / mTileLayerChunksPerRow) * mTileLayerChunkSideLength;
+    int firstCol = (chunkIndex % mTileLayerChunksPerRow) * mTileLayerChunkSideLength;
+    int lastRow = std::min(firstRow + mTileLayerChunkSideLength, MAP_HEIGHT_IN_TILES) - 1;
+    int lastCol = std::min(firstCol + mTileLayerChunkSideLength, MAP_WIDTH_IN_TILES) - 1;
+
+    // Chunks on the map's edges are cut short
+    if (chunk.mTexture == nullptr)
+    {
+        chunk.mTexture.reset(SDL_CreateTexture(mRenderer, SDL_PIXELFORMAT_RGBA8888, SDL_TEXTUREACCESS_TARGET, (lastCol - firstCol + 1) * TILE_SIDE_LENGTH, (lastRow - firstRow + 1) * TILE_SIDE_LENGTH));
+        if (chunk.mTexture == nullptr || SDL_SetTextureBlendMode(chunk.mTexture.get(), SDL_BLENDMODE_BLEND) != 0)
+        {
+            fprintf(stderr, "%s", SDL_GetError());
+            return false;
+        }
+    }
+
+    // Draw into the chunk's texture instead of the screen
+    SDL_Texture* previousTarget = SDL_GetRenderTarget(mRenderer);
+    if (SDL_SetRenderTarget(mRenderer, chunk.mTexture.get()) != 0)
+    {
+        fprintf(stderr, "%s", SDL_GetError());
+        return false;
+    }
+
+    // Start from a transparent texture, keeping the renderer's draw color
+    Uint8 red, green, blue, alpha;
+    SDL_GetRenderDrawColor(mRenderer, &red, &green, &blue, &alpha);
+    SDL_SetRenderDrawColor(mRenderer, 0, 0, 0, 0);
+    SDL_RenderClear(mRenderer);
+    SDL_SetRenderDrawColor(mRenderer, red, green, blue, alpha);
+
+    float originX = static_cast<float>(firstCol * TILE_SIDE_LENGTH);
+    float originY = static_cast<float>(firstRow * TILE_SIDE_LENGTH);
+    // Once batching has failed, chunks are baked tile by tile until the layer is invalidated, the baked chunk is cached either way
+    if (mTileLayerBatchFailed || drawTilesBatched(firstRow, firstCol, lastRow, lastCol, originX, originY) == false)
+    {
+        if (mTileLayerBatchFailed == false)
+            fprintf(stderr, "Unable to batch the tile layer, baking chunks tile by tile\n");
+        mTileLayerBatchFailed = true;
+        drawTiles(firstRow, firstCol, lastRow, lastCol, originX, originY);
+    }
+
+    SDL_SetRenderTarget(mRenderer, previousTarget);
+    chunk.mStale = false;
+    return true;
+}
+
+void Map::evictTileLayerChunks()
+{
+    // Drop the chunks that have gone the longest without being drawn, never ones drawn this frame
+    while (mTileLayer.size() > MAX_TILE_LAYER_CHUNKS)
+    {
+        auto oldest = std::min_element(mTileLayer.begin(), mTileLayer.end(), [](const auto& op1, const auto& op2) { return op1.second.mLastUsedFrame < op2.second.mLastUsedFrame; });
+        if (oldest->second.mLastUsedFrame == mFrame)
+            return;
+
+        mTileLayer.erase(oldest);
+    }
+}
+
+void Map::setTileRenderMode(TileRenderMode mode)
+{
+    if (mode == CACHED_TILE_LAYER && (mRenderer == nullptr || SDL_RenderTargetSupported(mRenderer) == SDL_FALSE))
+        mode = BATCHED_TILES;
+
+    mRenderMode = mode;
+}
+
+void Map::invalidateTileLayer()
+{
+    // The textures themselves may be gone (e.g, after a device reset), so they're recreated too
+    mTileLayer.clear();
+
+    // The renderer may be able to batch again
+    mTileLayerBatchFailed = false;
+}
+
+void Map::prefetch(const SDL_FRect& area)
+{
+    if (!mTiles.isStreamed())
+        return;
+
+    int firstRow = std::max(static_cast<int>(area.y) / TILE_SIDE_LENGTH - PREFETCH_MARGIN, 0);
+    int lastRow = std::min(static_cast<int>(area.y + area.h) / TILE_SIDE_LENGTH + PREFETCH_MARGIN, MAP_HEIGHT_IN_TILES - 1);
+    int firstCol = std::max(static_cast<int>(area.x) / TILE_SIDE_LENGTH - PREFETCH_MARGIN, 0);
+    int lastCol = std::min(static_cast<int>(area.x + area.w) / TILE_SIDE_LENGTH + PREFETCH_MARGIN, MAP_WIDTH_IN_TILES - 1);
+
+    // Entirely outside of the map
+    if (firstRow > lastRow || firstCol > lastCol)
+        return;
+
+    mTiles.request(firstRow, firstCol, lastRow, lastCol);
+}
+
+void Map::updateStreaming()
+{
+    mTiles.update();
+}
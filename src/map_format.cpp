@@ -0,0 +1,371 @@
+#include "../header/map_format.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+
+using namespace MapInternals;
+
+namespace MapFormat
+{
+    bool readTextMap(const std::string& path, MapData& map)
+    {
+        // Open the map
+        std::ifstream tileMapFile{ path };
+
+        // If the map couldn't be loaded
+        if (tileMapFile.is_open() == false)
+        {
+            fprintf(stderr, "Unable to load map file!\n");
+            return false;
+        }
+
+        // Quick way to check every read-in
+        auto check = [&tileMapFile]()
+        {
+            if (tileMapFile.good() == false)
+            {
+                fprintf(stderr, "Failed to load map: read-in unsuccesful\n");
+                return false;
+            }
+            return true;
+        };
+
+        // Read in each header value, they're preceded by a label and a space
+        auto readValue = [&tileMapFile, &check](int& value)
+        {
+            tileMapFile.ignore(std::numeric_limits<std::streamsize>::max(), ' ');   // skip everything up to and including space
+            tileMapFile >> value;
+            if (check() == false)               // Check if read-in was successful
+                return false;
+            tileMapFile.ignore(1, '\n');        // Move on to next line
+            return true;
+        };
+
+        if (!readValue(map.mTileSideLength) || !readValue(map.mWidthInTiles) || !readValue(map.mHeightInTiles))
+            return false;
+
+        if (map.mTileSideLength <= 0 || map.mWidthInTiles <= 0 || map.mHeightInTiles <= 0)
+        {
+            fprintf(stderr, "Failed to load map: invalid dimensions\n");
+            return false;
+        }
+
+        map.mTiles.assign(static_cast<std::size_t>(map.mWidthInTiles) * map.mHeightInTiles, MISC_TILE);
+
+        // Read the tiles in row major order
+        for (auto& tile : map.mTiles)
+        {
+            int readInTileType = -1;
+
+            // Read tile type from file
+            tileMapFile >> readInTileType;
+
+            // Check if read-in was successfull
+            if (tileMapFile.fail())
+            {
+                fprintf(stderr, "Failed to load map: read-in unsuccesful\n");
+                return false;
+            }
+
+            // Invalid tile type
+            if (readInTileType <= -1 || readInTileType >= TOTAL_TILE_TYPES)
+            {
+                fprintf(stderr, "Failed to load map: invalid tile type\n");
+                return false;
+            }
+            tile = static_cast<std::uint8_t>(readInTileType);
+        }
+        return true;
+    }
+
+    // Appends a chunk's tiles to the output as (run length, tile type) pairs
+    static void compressChunk(const MapData& map, int firstRow, int firstCol, int chunkSideLength, std::vector<std::uint8_t>& output)
+    {
+        int lastRow = std::min(firstRow + chunkSideLength, map.mHeightInTiles);
+        int lastCol = std::min(firstCol + chunkSideLength, map.mWidthInTiles);
+
+        std::uint8_t runType = 0;
+        std::uint8_t runLength = 0;
+
+        for (int iRow = firstRow; iRow < lastRow; ++iRow)
+        {
+            for (int iCol = firstCol; iCol < lastCol; ++iCol)
+            {
+                std::uint8_t type = map.mTiles[static_cast<std::size_t>(iRow) * map.mWidthInTiles + iCol];
+
+                // Extend the current run if possible, otherwise flush it and start a new one
+                if (runLength > 0 && type == runType && runLength < std::numeric_limits<std::uint8_t>::max())
+                {
+                    ++runLength;
+                    continue;
+                }
+
+                if (runLength > 0)
+                {
+                    output.push_back(runLength);
+                    output.push_back(runType);
+                }
+                runType = type;
+                runLength = 1;
+            }
+        }
+
+        // Flush the last run
+        if (runLength > 0)
+        {
+            output.push_back(runLength);
+            output.push_back(runType);
+        }
+    }
+
+    bool writeBinaryMap(const std::string& path, const MapData& map, bool compress)
+    {
+        Header header{};
+        std::memcpy(header.mMagic, MAGIC, sizeof(MAGIC));
+        header.mVersion = VERSION;
+        header.mTileSideLength = static_cast<std::uint32_t>(map.mTileSideLength);
+        header.mWidthInTiles = static_cast<std::uint32_t>(map.mWidthInTiles);
+        header.mHeightInTiles = static_cast<std::uint32_t>(map.mHeightInTiles);
+        header.mFlags = compress ? FLAG_CHUNK_COMPRESSED : 0;
+        header.mChunkSideLength = compress ? DEFAULT_CHUNK_SIDE_LENGTH : 0;
+
+        std::vector<std::uint8_t> body;
+
+        if (compress)
+        {
+            int chunkSide = static_cast<int>(DEFAULT_CHUNK_SIDE_LENGTH);
+            int chunksPerRow = (map.mWidthInTiles + chunkSide - 1) / chunkSide;
+            int chunksPerCol = (map.mHeightInTiles + chunkSide - 1) / chunkSide;
+            std::size_t chunkCount = static_cast<std::size_t>(chunksPerRow) * chunksPerCol;
+
+            // The offset table is followed by the chunks, the extra offset marks the end of the last chunk
+            std::vector<std::uint32_t> offsets;
+            std::vector<std::uint8_t> chunks;
+            std::size_t dataStart = sizeof(Header) + (chunkCount + 1) * sizeof(std::uint32_t);
+
+            for (int iChunkRow = 0; iChunkRow < chunksPerCol; ++iChunkRow)
+            {
+                for (int iChunkCol = 0; iChunkCol < chunksPerRow; ++iChunkCol)
+                {
+                    offsets.push_back(static_cast<std::uint32_t>(dataStart + chunks.size()));
+                    compressChunk(map, iChunkRow * chunkSide, iChunkCol * chunkSide, chunkSide, chunks);
+                }
+            }
+            offsets.push_back(static_cast<std::uint32_t>(dataStart + chunks.size()));
+
+            if (dataStart + chunks.size() > std::numeric_limits<std::uint32_t>::max())
+            {
+                fprintf(stderr, "Failed to write map: compressed map is too large\n");
+                return false;
+            }
+
+            body.resize(offsets.size() * sizeof(std::uint32_t));
+            std::memcpy(body.data(), offsets.data(), body.size());
+            body.insert(body.end(), chunks.begin(), chunks.end());
+        }
+        else
+        {
+            // Tiles, padding, then the wall bitmap
+            body.resize(getPackedFileSize(header) - sizeof(Header), 0);
+            std::memcpy(body.data(), map.mTiles.data(), map.mTiles.size());
+
+            std::vector<std::uint64_t> wallBits(getWallBitsWordCount(getBorderedTileCount(header.mWidthInTiles, header.mHeightInTiles)));
+            buildWallBits(map.mTiles.data(), header.mWidthInTiles, header.mHeightInTiles, wallBits.data());
+            std::memcpy(body.data() + (getWallBitsOffset(header) - sizeof(Header)), wallBits.data(), wallBits.size() * sizeof(std::uint64_t));
+        }
+
+        std::ofstream output{ path, std::ios::binary | std::ios::trunc };
+        if (output.is_open() == false)
+        {
+            fprintf(stderr, "Unable to open %s for writing\n", path.c_str());
+            return false;
+        }
+
+        output.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        output.write(reinterpret_cast<const char*>(body.data()), static_cast<std::streamsize>(body.size()));
+
+        if (output.good() == false)
+        {
+            fprintf(stderr, "Failed to write map: write unsuccessful\n");
+            return false;
+        }
+        return true;
+    }
+
+    const Header* getHeader(const std::uint8_t* data, std::size_t size)
+    {
+        if (data == nullptr || size < sizeof(Header))
+            return nullptr;
+
+        const Header* header = reinterpret_cast<const Header*>(data);
+
+        // Not a binary map, or written by an incompatible version
+        if (std::memcmp(header->mMagic, MAGIC, sizeof(MAGIC)) != 0 || header->mVersion != VERSION)
+            return nullptr;
+
+        if (header->mTileSideLength == 0 || header->mWidthInTiles == 0 || header->mHeightInTiles == 0)
+            return nullptr;
+
+        // Tile indices are ints, including those of the wall bitmap's border
+        if ((static_cast<std::uint64_t>(header->mWidthInTiles) + 2) * (static_cast<std::uint64_t>(header->mHeightInTiles) + 2) > static_cast<std::uint64_t>(std::numeric_limits<int>::max()))
+            return nullptr;
+
+        if (header->mFlags & FLAG_CHUNK_COMPRESSED)
+        {
+            if (header->mChunkSideLength == 0)
+                return nullptr;
+        }
+        // Packed maps must hold every tile and the wall bitmap
+        else if (size < getPackedFileSize(*header))
+            return nullptr;
+
+        return header;
+    }
+
+    std::size_t getTilesOffset() { return sizeof(Header); }
+
+    std::size_t getWallBitsOffset(const Header& header)
+    {
+        std::size_t tilesEnd = getTilesOffset() + static_cast<std::size_t>(header.mWidthInTiles) * header.mHeightInTiles;
+
+        // Align the bitmap to its word size
+        return (tilesEnd + 7) & ~static_cast<std::size_t>(7);
+    }
+
+    std::size_t getPackedFileSize(const Header& header)
+    {
+        return getWallBitsOffset(header) + getWallBitsWordCount(getBorderedTileCount(header.mWidthInTiles, header.mHeightInTiles)) * sizeof(std::uint64_t);
+    }
+
+    std::size_t getWallBitsWordCount(std::size_t tileCount) { return (tileCount + 63) / 64; }
+
+    std::size_t getBorderedTileCount(std::size_t widthInTiles, std::size_t heightInTiles) { return (widthInTiles + 2) * (heightInTiles + 2); }
+
+    void buildWallBits(const std::uint8_t* tiles, std::size_t widthInTiles, std::size_t heightInTiles, std::uint64_t* wallBits)
+    {
+        // Start with every tile as a wall, bits past the last tile are left clear
+        std::size_t borderedCount = getBorderedTileCount(widthInTiles, heightInTiles);
+        std::size_t wordCount = getWallBitsWordCount(borderedCount);
+        std::fill(wallBits, wallBits + wordCount, ~std::uint64_t{ 0 });
+        if (borderedCount % 64 != 0)
+            wallBits[wordCount - 1] = (std::uint64_t{ 1 } << (borderedCount % 64)) - 1;
+
+        // Then clear the tiles that aren't walls, each row of the grid starts a border tile in
+        for (std::size_t iRow = 0; iRow < heightInTiles; ++iRow)
+        {
+            for (std::size_t iCol = 0; iCol < widthInTiles; ++iCol)
+            {
+                if (tiles[iRow * widthInTiles + iCol] == WALL_TILE)
+                    continue;
+
+                std::size_t bordered = (iRow + 1) * (widthInTiles + 2) + iCol + 1;
+                wallBits[bordered >> 6] &= ~(std::uint64_t{ 1 } << (bordered & 63));
+            }
+        }
+    }
+
+    bool checkPackedTiles(const std::uint8_t* data, const Header& header)
+    {
+        std::size_t tileCount = static_cast<std::size_t>(header.mWidthInTiles) * header.mHeightInTiles;
+        const std::uint8_t* tiles = data + getTilesOffset();
+
+        for (std::size_t iTile = 0; iTile < tileCount; ++iTile)
+        {
+            if (tiles[iTile] >= TOTAL_TILE_TYPES)
+                return false;
+        }
+
+        // Rebuild the wall bitmap from the tile types, the stored one must match it bit for bit (border and unused bits included)
+        std::vector<std::uint64_t> expected(getWallBitsWordCount(getBorderedTileCount(header.mWidthInTiles, header.mHeightInTiles)));
+        buildWallBits(tiles, header.mWidthInTiles, header.mHeightInTiles, expected.data());
+        return std::memcmp(data + getWallBitsOffset(header), expected.data(), expected.size() * sizeof(std::uint64_t)) == 0;
+    }
+
+    int getChunksPerRow(const Header& header)
+    {
+        return static_cast<int>((header.mWidthInTiles + header.mChunkSideLength - 1) / header.mChunkSideLength);
+    }
+
+    int getChunksPerColumn(const Header& header)
+    {
+        return static_cast<int>((header.mHeightInTiles + header.mChunkSideLength - 1) / header.mChunkSideLength);
+    }
+
+    bool decompressChunk(const std::uint8_t* data, std::size_t size, std::size_t chunkIndex, std::uint8_t* tiles, std::size_t stride)
+    {
+        const Header* header = getHeader(data, size);
+        if (header == nullptr || (header->mFlags & FLAG_CHUNK_COMPRESSED) == 0)
+            return false;
+
+        int width = static_cast<int>(header->mWidthInTiles);
+        int height = static_cast<int>(header->mHeightInTiles);
+        int chunkSide = static_cast<int>(header->mChunkSideLength);
+        int chunksPerRow = getChunksPerRow(*header);
+        std::size_t chunkCount = static_cast<std::size_t>(chunksPerRow) * getChunksPerColumn(*header);
+
+        // The offset table must fit in the file
+        if (chunkIndex >= chunkCount || sizeof(Header) + (chunkCount + 1) * sizeof(std::uint32_t) > size)
+            return false;
+
+        const std::uint8_t* offsetTable = data + sizeof(Header);
+
+        std::uint32_t begin, end;
+        std::memcpy(&begin, offsetTable + chunkIndex * sizeof(std::uint32_t), sizeof(std::uint32_t));
+        std::memcpy(&end, offsetTable + (chunkIndex + 1) * sizeof(std::uint32_t), sizeof(std::uint32_t));
+
+        if (begin > end || end > size || (end - begin) % 2 != 0)
+            return false;
+
+        int firstRow = static_cast<int>(chunkIndex / chunksPerRow) * chunkSide;
+        int firstCol = static_cast<int>(chunkIndex % chunksPerRow) * chunkSide;
+        int chunkWidth = std::min(chunkSide, width - firstCol);
+        int chunkHeight = std::min(chunkSide, height - firstRow);
+
+        // Expand the runs, filling the chunk in row major order
+        int filled = 0;
+        for (std::uint32_t iRun = begin; iRun < end; iRun += 2)
+        {
+            std::uint8_t runLength = data[iRun];
+            std::uint8_t runType = data[iRun + 1];
+
+            if (runType >= TOTAL_TILE_TYPES || filled + runLength > chunkWidth * chunkHeight)
+                return false;
+
+            for (int i = 0; i < runLength; ++i, ++filled)
+                tiles[static_cast<std::size_t>(filled / chunkWidth) * stride + filled % chunkWidth] = runType;
+        }
+
+        // Every tile in the chunk must be covered
+        return filled == chunkWidth * chunkHeight;
+    }
+
+    bool decompressTiles(const std::uint8_t* data, std::size_t size, std::uint8_t* tiles)
+    {
+        const Header* header = getHeader(data, size);
+        if (header == nullptr || (header->mFlags & FLAG_CHUNK_COMPRESSED) == 0)
+            return false;
+
+        std::size_t width = header->mWidthInTiles;
+        int chunkSide = static_cast<int>(header->mChunkSideLength);
+        int chunksPerRow = getChunksPerRow(*header);
+        std::size_t chunkCount = static_cast<std::size_t>(chunksPerRow) * getChunksPerColumn(*header);
+
+        // Decode each chunk straight into its place in the grid
+        for (std::size_t iChunk = 0; iChunk < chunkCount; ++iChunk)
+        {
+            std::size_t firstRow = (iChunk / chunksPerRow) * chunkSide;
+            std::size_t firstCol = (iChunk % chunksPerRow) * chunkSide;
+
+            if (decompressChunk(data, size, iChunk, tiles + firstRow * width + firstCol, width) == false)
+                return false;
+        }
+        return true;
+    }
+}
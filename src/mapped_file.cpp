@@ -0,0 +1,121 @@
+#include "../header/mapped_file.h"
+
+#include <SDL.h>
+
+#include <cstddef>
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+#ifdef _WIN32
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	mFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		mFile = nullptr;
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (GetFileSizeEx(mFile, &fileSize) == 0 || fileSize.QuadPart == 0)
+	{
+		close();
+		return false;
+	}
+
+	// Copy-on-write view, pages are only copied if they're written to
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (mMapping == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	mData = static_cast<Uint8*>(MapViewOfFile(mMapping, FILE_MAP_COPY, 0, 0, 0));
+	if (mData == nullptr)
+	{
+		close();
+		return false;
+	}
+
+	mSize = static_cast<std::size_t>(fileSize.QuadPart);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData != nullptr)
+		UnmapViewOfFile(mData);
+	if (mMapping != nullptr)
+		CloseHandle(mMapping);
+	if (mFile != nullptr)
+		CloseHandle(mFile);
+
+	mData = nullptr;
+	mMapping = nullptr;
+	mFile = nullptr;
+	mSize = 0;
+}
+#else
+bool MappedFile::open(const std::string& path)
+{
+	close();
+
+	int file = ::open(path.c_str(), O_RDONLY);
+	if (file == -1)
+		return false;
+
+	struct stat fileInfo;
+	if (fstat(file, &fileInfo) != 0 || fileInfo.st_size == 0)
+	{
+		::close(file);
+		return false;
+	}
+
+	// Private mapping, pages are only copied if they're written to
+	void* data = mmap(nullptr, static_cast<std::size_t>(fileInfo.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, file, 0);
+
+	// The mapping keeps its own reference to the file
+	::close(file);
+
+	if (data == MAP_FAILED)
+		return false;
+
+	mData = static_cast<Uint8*>(data);
+	mSize = static_cast<std::size_t>(fileInfo.st_size);
+	return true;
+}
+
+void MappedFile::close()
+{
+	if (mData != nullptr)
+		munmap(mData, mSize);
+
+	mData = nullptr;
+	mSize = 0;
+}
+#endif
+
+bool MappedFile::isOpen() const { return mData != nullptr; }
+
+Uint8* MappedFile::getData() const { return mData; }
+
+std::size_t MappedFile::getSize() const { return mSize; }
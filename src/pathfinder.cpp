@@ -11,11 +11,10 @@
 #include <algorithm>
 #include <cmath>
 #include <functional>
+#include <string>
 
 #define DIAGONAL_DISTANCE 14.f
 #define ACROSS_DISTANCE 10.f
-#define RAYCAST_WIDTH 40.f
-#define RAYCAST_LENGTH 10.f
 
 
 using namespace MapInternals;
@@ -26,15 +25,13 @@ void NodeInfo::reset()
 {
     mHcost = 0;
     mGcost = 0;
-    mParent = nullptr;
+    mParent = -1;
 }
 
-int NodeInfo::getFcost() { return mGcost + mHcost; }
+int NodeInfo::getFcost() const { return mGcost + mHcost; }
 
-Pathfinder::Pathfinder(SDL_Renderer* defaultRenderer) : Map{ defaultRenderer }
+Pathfinder::Pathfinder(SDL_Renderer* defaultRenderer, const std::string& mapPath) : Map{ defaultRenderer, mapPath, false }
 {
-    heapComp = [this](Tile* op2, Tile* op1) { return higherPotential(op2, op1); };
-
     // Build pathfinding graphs
     buildRouteGraph();
     connectRouteGraph();
@@ -44,33 +41,21 @@ Pathfinder::Pathfinder(SDL_Renderer* defaultRenderer) : Map{ defaultRenderer }
 
 Pathfinder::~Pathfinder() {}
 
-bool Pathfinder::isAccessible(const Tile* startTile, const Tile* destTile)
+bool Pathfinder::isAccessible(int startTile, int destTile, float agentRadius) const
 {
-    Vec startPoint;
-    startPoint.setX(static_cast<float>(startTile->getCollisionBox()->x) + static_cast<float>(TILE_SIDE_LENGTH) / 2.f);
-    startPoint.setY(static_cast<float>(startTile->getCollisionBox()->y) + static_cast<float>(TILE_SIDE_LENGTH) / 2.f);
-
-    Vec destPoint;
-    destPoint.setX(static_cast<float>(destTile->getCollisionBox()->x) + static_cast<float>(TILE_SIDE_LENGTH) / 2.f);
-    destPoint.setY(static_cast<float>(destTile->getCollisionBox()->y) + static_cast<float>(TILE_SIDE_LENGTH) / 2.f);
-
-    return isAccessible(startPoint, destPoint);
+    return isAccessible(getTileCentre(startTile), getTileCentre(destTile), agentRadius);
 }
 
-bool Pathfinder::isAccessible(const SDL_FRect& entity, const Tile* destTile)
+bool Pathfinder::isAccessible(const SDL_FRect& entity, int destTile, float agentRadius) const
 {
     Vec startPoint;
     startPoint.setX(entity.x + entity.w / 2.f);
     startPoint.setY(entity.y + entity.h / 2.f);
 
-    Vec destPoint;
-    destPoint.setX(static_cast<float>(destTile->getCollisionBox()->x) + static_cast<float>(TILE_SIDE_LENGTH) / 2.f);
-    destPoint.setY(static_cast<float>(destTile->getCollisionBox()->y) + static_cast<float>(TILE_SIDE_LENGTH) / 2.f);
-
-    return isAccessible(startPoint, destPoint);
+    return isAccessible(startPoint, getTileCentre(destTile), agentRadius);
 }
 
-bool Pathfinder::isAccessible(const SDL_FRect& startEntity, const SDL_FRect& destEntity)
+bool Pathfinder::isAccessible(const SDL_FRect& startEntity, const SDL_FRect& destEntity, float agentRadius) const
 {
     Vec startPoint;
     startPoint.setX(startEntity.x + startEntity.w / 2.f);
@@ -80,65 +65,19 @@ bool Pathfinder::isAccessible(const SDL_FRect& startEntity, const SDL_FRect& des
     destPoint.setX(destEntity.x + destEntity.w / 2.f);
     destPoint.setY(destEntity.y + destEntity.h / 2.f);
 
-    return isAccessible(startPoint, destPoint);
+    return isAccessible(startPoint, destPoint, agentRadius);
 }
 
-bool Pathfinder::isAccessible(const Vec& startPoint, const Vec& destPoint)
+bool Pathfinder::isAccessible(const Vec& startPoint, const Vec& destPoint, float agentRadius) const
 {
-    // Cast a ray between 2 points and check for wall tiles along the ray
-
-    // Get vector between start and dest
-    Vec orthagonal{ destPoint - startPoint };
-
-    // Make it orthagonal to itself
-    orthagonal *= Matrix{ 0, -1, 1, 0 };
-
-    // Normalize it
-    orthagonal.normalize();
-
-    // Create 2 parallel lines to the initial start-dest line (using the perpendicular unit vector)
-    // StartA ----- DestA
-    // Start -------- Dest
-    // StartB ----- DestB
-    // RAYCAST_WIDTH is the distance between the initial line and A or B line
-    Vec shiftedStartPointA = startPoint;
-    shiftedStartPointA += orthagonal * (RAYCAST_WIDTH / 2.f);
-
-    Vec shiftedDestPointA = destPoint;
-    shiftedDestPointA += orthagonal * (RAYCAST_WIDTH / 2.f);
-
-    Vec shiftedStartPointB = startPoint;
-    shiftedStartPointB -= orthagonal * (RAYCAST_WIDTH / 2.f);
-
-    Vec shiftedDestPointB = destPoint;
-    shiftedDestPointB -= orthagonal * (RAYCAST_WIDTH / 2.f);
-
-    // Get current vectors, will be gradually increased from start point to dest point
-    Vec currentA{ shiftedStartPointA };
-    Vec currentB{ shiftedStartPointB };
-
-    // Unit vector to move both current A and B vectors 
-    Vec currentUnitVec{ destPoint - startPoint };
-    currentUnitVec.normalize();
-
-    // The tiles that the current vectors fall on
-    Tile* currentTileA = getTileFromWorldPoint(currentA);
-    Tile* currentTileB = getTileFromWorldPoint(currentB);
-
-    while (currentTileA->getType() != WALL_TILE && currentTileB->getType() != WALL_TILE)
-    {
-        // Reached destination, success (if A finished, then so did B)
-        if ((shiftedDestPointA - currentA).getMagnitude() <= 10.f)
-            return true;
-
-        // Move towards destination at constant rate
-        currentA += currentUnitVec * RAYCAST_LENGTH;
-        currentB += currentUnitVec * RAYCAST_LENGTH;
+    // Read the clearance map along the line instead of sweeping a ray as wide as the agent
+    return hasLineOfSight(startPoint, destPoint, agentRadius);
+}
 
-        currentTileA = getTileFromWorldPoint(currentA);
-        currentTileB = getTileFromWorldPoint(currentB);
-    }
-    return false;
+float Pathfinder::getEdgeClearance(int startTile, int destTile) const
+{
+    // Stop tracing once the edge is too narrow for the smallest agent
+    return getClearance(getTileCentre(startTile), getTileCentre(destTile), MIN_AGENT_RADIUS);
 }
 
 void Pathfinder::buildRouteGraph()
@@ -150,10 +89,8 @@ void Pathfinder::buildRouteGraph()
     {
         for (int iCol = 0; iCol < MAP_WIDTH_IN_TILES; ++iCol)
         {
-            Tile* tile = &mTiles[iRow][iCol];
-
             // Skip wall tiles
-            if (tile->getType() == WALL_TILE)
+            if (mTiles.isWall(iRow, iCol))
                 continue;
 
             bool isNode = false;
@@ -173,57 +110,56 @@ void Pathfinder::buildRouteGraph()
 
             // Check for isolated diagonal adjacencies
             // Upper left
-            if (firstRow < iRow && firstCol < iCol && (mTiles[firstRow][firstCol]).getType() == WALL_TILE && (mTiles[iRow - 1][iCol]).getType() != WALL_TILE && (mTiles[iRow][iCol - 1]).getType() != WALL_TILE)
+            if (firstRow < iRow && firstCol < iCol && mTiles.isWall(firstRow, firstCol) && !mTiles.isWall(iRow - 1, iCol) && !mTiles.isWall(iRow, iCol - 1))
                 isNode = true;
             // Upper right
-            else if (firstRow < iRow && lastCol > iCol && (mTiles[firstRow][lastCol]).getType() == WALL_TILE && (mTiles[iRow - 1][iCol]).getType() != WALL_TILE && (mTiles[iRow][iCol + 1]).getType() != WALL_TILE)
+            else if (firstRow < iRow && lastCol > iCol && mTiles.isWall(firstRow, lastCol) && !mTiles.isWall(iRow - 1, iCol) && !mTiles.isWall(iRow, iCol + 1))
                 isNode = true;
             // Lower right
-            else if (lastRow > iRow && lastCol > iCol && (mTiles[lastRow][lastCol]).getType() == WALL_TILE && (mTiles[iRow + 1][iCol]).getType() != WALL_TILE && (mTiles[iRow][iCol + 1]).getType() != WALL_TILE)
+            else if (lastRow > iRow && lastCol > iCol && mTiles.isWall(lastRow, lastCol) && !mTiles.isWall(iRow + 1, iCol) && !mTiles.isWall(iRow, iCol + 1))
                 isNode = true;
             // Lower left
-            else if (lastRow > iRow && firstCol < iCol && (mTiles[lastRow][firstCol]).getType() == WALL_TILE && (mTiles[iRow + 1][iCol]).getType() != WALL_TILE && (mTiles[iRow][iCol - 1]).getType() != WALL_TILE)
+            else if (lastRow > iRow && firstCol < iCol && mTiles.isWall(lastRow, firstCol) && !mTiles.isWall(iRow + 1, iCol) && !mTiles.isWall(iRow, iCol - 1))
                 isNode = true;
 
             if (isNode == true)
             {
-                NodeInfo temp;
-                mRouteGraph.insert({ tile, temp });
+                mRouteGraph.insert({ mTiles.getIndex(iRow, iCol), std::vector<GraphEdge>{} });
             }
         }
     }
 }
 
+std::vector<int> Pathfinder::getRouteNodes() const
+{
+    // In tile order, so edges are added in the same order as searching the whole tilemap would
+    std::vector<int> routeNodes;
+    routeNodes.reserve(mRouteGraph.size());
+    for (const auto& node : mRouteGraph)
+        routeNodes.push_back(node.first);
+
+    std::sort(routeNodes.begin(), routeNodes.end());
+    return routeNodes;
+}
+
 void Pathfinder::connectRouteGraph()
 {
-    // Search entire tilemap and add all valid tiles to the graph
-    for (auto& iRow : mTiles)
-    {   
-        for (auto& iTile : iRow)
+    std::vector<int> routeNodes = getRouteNodes();
+
+    // Match every node to every other node
+    for (int startTile : routeNodes)
+    {
+        std::vector<GraphEdge>& edges = mRouteGraph.at(startTile);
+        for (int destTile : routeNodes)
         {
-            Tile* startTile = &iTile;
-            // If the current tile is a node, match it to every other node
-            if (mRouteGraph.count(startTile) != 1)
+            // Avoid relating the current node to itself
+            if (destTile == startTile)
                 continue;
-        
-            for (auto& jRow : mTiles)
-            {   
-                for (auto& jTile : jRow)
-                {
-                    Tile* destTile = &jTile;
-                    // Avoid relating the current node to itself
-                    if (destTile == startTile)
-                        continue;
-
-                    // If dest tile is a node
-                    if (mRouteGraph.count(destTile) == 1)
-                    {
-                        // If dest is accessible from start, add it as a neighbor
-                        if (isAccessible(startTile, destTile))
-                            mRouteGraph.at(startTile).mNeighbours.push_back(destTile);
-                    }
-                }
-            }
+
+            // If dest is accessible from start, add it as a neighbor along with how wide the edge is
+            float clearance = getEdgeClearance(startTile, destTile);
+            if (clearance >= MIN_AGENT_RADIUS)
+                edges.push_back(GraphEdge{ destTile, clearance });
         }
     }
 }
@@ -232,70 +168,43 @@ void Pathfinder::buildRampGraph()
 {
     // Ramp graph nodes are all the tiles that aren't graph nodes or wall tiles
     // Search entire tilemap and add all valid tiles to the graph
-    for (auto& iRow : mTiles)
+    for (int currentTile = 0; currentTile < TOTAL_TILES; ++currentTile)
     {
-        for (auto& iTile : iRow)
+        // If the current tile is not a wall or a node, it is a ramp node
+        if (!mTiles.isWall(currentTile) && mRouteGraph.count(currentTile) == 0)
         {
-
-            Tile* currentTile = &iTile;
-
-            // If the current tile is not a wall or a node, it is a ramp node
-            if (currentTile->getType() != WALL_TILE && mRouteGraph.count(currentTile) == 0)
-            {
-                std::vector<Tile*> temp;
-                mRampGraph.insert({ currentTile, temp });
-            }
+            std::vector<GraphEdge> temp;
+            mRampGraph.insert({ currentTile, temp });
         }
     }
 }
 
 void Pathfinder::connectRampGraph()
 {
-    // Search entire tilemap and add all valid tiles to the graph
-    for (auto& iRow : mTiles)
+    std::vector<int> routeNodes = getRouteNodes();
+
+    // Match every ramp node to every route node
+    for (auto& [startTile, edges] : mRampGraph)
     {
-        for (auto& iTile : iRow)
+        for (int destTile : routeNodes)
         {
-            Tile* startTile = &iTile;
-
-            // If the current tile is a ramp node, match it to every other node
-            if (mRampGraph.count(startTile) == 1)
-            {
-                for (auto& jRow : mTiles)
-                {
-                    for (auto& jTile : jRow)
-                    {
-                        Tile* destTile = &jTile;
-
-                        // Avoid relating the current node to itself
-                        if (destTile == startTile)
-                            continue;
-
-                        // If jTile is a node
-                        if (mRouteGraph.count(destTile) == 1)
-                        {
-                            // If dest is accessible from start, add it as a neighbor
-                            if (isAccessible(startTile, destTile))
-                                mRampGraph.at(startTile).push_back(destTile);
-
-                            // Sort by closest neighbors
-                            auto comp = [this, startTile](Tile* op1, Tile* op2) { return closerNode(startTile, op1, op2); };
-                            sort(mRampGraph.at(startTile).begin(), mRampGraph.at(startTile).end(), comp);
-                        }
-                    }
-                }
-            }
+            // If dest is accessible from start, add it as a neighbor along with how wide the edge is
+            float clearance = getEdgeClearance(startTile, destTile);
+            if (clearance >= MIN_AGENT_RADIUS)
+                edges.push_back(GraphEdge{ destTile, clearance });
         }
+
+        // Sort by closest neighbors once they're all found, equally close ones stay in tile order
+        int rampTile = startTile;
+        auto comp = [this, rampTile](const GraphEdge& op1, const GraphEdge& op2) { return closerNode(rampTile, op1.mNode, op2.mNode); };
+        std::stable_sort(edges.begin(), edges.end(), comp);
     }
 }
 
-int Pathfinder::getDistance(const Tile* startTile, const Tile* endTile) const
+int Pathfinder::getDistance(int startTile, int endTile) const
 {
-    const SDL_Rect* start = startTile->getCollisionBox();
-    const SDL_Rect* end = endTile->getCollisionBox();
-
-    int deltaX = abs(start->x - end->x) / TILE_SIDE_LENGTH;
-    int deltaY = abs(start->y - end->y) / TILE_SIDE_LENGTH;
+    int deltaX = abs(mTiles.getCol(startTile) - mTiles.getCol(endTile));
+    int deltaY = abs(mTiles.getRow(startTile) - mTiles.getRow(endTile));
 
     if (deltaX > deltaY)
         return (static_cast<int>(DIAGONAL_DISTANCE) * deltaY) + (static_cast<int>(ACROSS_DISTANCE) * (deltaX - deltaY));
@@ -303,34 +212,30 @@ int Pathfinder::getDistance(const Tile* startTile, const Tile* endTile) const
         return (static_cast<int>(DIAGONAL_DISTANCE) * deltaX) + (static_cast<int>(ACROSS_DISTANCE) * (deltaY - deltaX));
 }
 
-float Pathfinder::getDistance(const Vec& startPoint, const Tile* endTile) const
+float Pathfinder::getDistance(const Vec& startPoint, int endTile) const
 {
-    const SDL_Rect* end = endTile->getCollisionBox();
-
-    // Find distance on both axes (add half of a tile to center point on tile)
-    Vec endPoint{ static_cast<float>(end->x + TILE_SIDE_LENGTH) / 2.f, static_cast<float>(end->y + TILE_SIDE_LENGTH) / 2.f };
-
-    // Return euclidean distance
-    return (endPoint - startPoint).getMagnitude();
+    // Return euclidean distance (to the centre of the tile)
+    return (getTileCentre(endTile) - startPoint).getMagnitude();
 }
 
 // Backtracks the route graph and create a list of points representing the path
-void Pathfinder::createPath(Tile* end, std::stack<SDL_Point>& path) const
+void Pathfinder::createPath(const PathSearch& search, int end, std::stack<SDL_Point>& path) const
 {
-    Tile* currentTile = end;
+    int currentTile = end;
     SDL_Point currentPoint;
 
     // Trace back untill a ramp node is found or the parent is null, exclude the first node
-    while (mRampGraph.count(currentTile) != 1 && mRouteGraph.at(currentTile).mParent != nullptr)
+    while (mRampGraph.count(currentTile) != 1 && search.mNodes.at(currentTile).mParent != -1)
     {
-        currentPoint.x = currentTile->mCollisionBox.x + TILE_SIDE_LENGTH / 2;
-        currentPoint.y = currentTile->mCollisionBox.y + TILE_SIDE_LENGTH / 2;
+        SDL_Rect tileBox = getTileBox(currentTile);
+        currentPoint.x = tileBox.x + TILE_SIDE_LENGTH / 2;
+        currentPoint.y = tileBox.y + TILE_SIDE_LENGTH / 2;
         path.push(currentPoint);
-        currentTile = mRouteGraph.at(currentTile).mParent;
+        currentTile = search.mNodes.at(currentTile).mParent;
     }
 }
 
-bool Pathfinder::closerNode(Tile* startTile, Tile* op1, Tile* op2)
+bool Pathfinder::closerNode(int startTile, int op1, int op2)
 {
     int op1Distance = getDistance(startTile, op1);
     int op2Distance = getDistance(startTile, op2);
@@ -342,55 +247,76 @@ bool Pathfinder::closerNode(Tile* startTile, Tile* op1, Tile* op2)
 }
 
 // Arguments are reversed for heap to store in ascending order
-bool Pathfinder::higherPotential(Tile* op2, Tile* op1)
+bool Pathfinder::higherPotential(const NodeInfo& op2, const NodeInfo& op1)
 {
-    if (mRouteGraph.at(op1).getFcost() < mRouteGraph.at(op2).getFcost())
+    if (op1.getFcost() < op2.getFcost())
         return true;
-    else if (mRouteGraph.at(op1).getFcost() == mRouteGraph.at(op2).getFcost() && mRouteGraph.at(op1).mHcost < mRouteGraph.at(op2).mHcost)
+    else if (op1.getFcost() == op2.getFcost() && op1.mHcost < op2.mHcost)
         return true;
     else
         return false;
 
     // Greedy A*
-   /*if (mRouteGraph.at(op1).mHcost < mRouteGraph.at(op2).mHcost)
+   /*if (op1.mHcost < op2.mHcost)
        return true;
    else
        return false;*/
 }
 
-bool Pathfinder::findPath(const Vec& startPoint, const Vec& dest, std::stack<SDL_Point>& path)
+bool Pathfinder::findPath(const Vec& startPoint, const Vec& dest, std::stack<SDL_Point>& path, float agentRadius) const
 {
-    // A* requires a start and destination point
-    Tile* firstTile = getTileFromWorldPoint(startPoint);    // The first tile on the path
-    Tile* lastTile = getTileFromWorldPoint(dest);  // The last tile on the path
-
-    // Can't pathfind outside of map bounds
-    if (firstTile == nullptr || lastTile == nullptr)
+    // Can't pathfind from or to wall tiles, which are in neither graph, the wall border makes this reject points outside of the map too
+    if (isInWall(startPoint) || isInWall(dest))
+    {
+        countOutOfBoundsLookup(startPoint);
+        countOutOfBoundsLookup(dest);
         return false;
+    }
+
+    // A* requires a start and destination point
+    int firstTile = getTileFromWorldPoint(startPoint);    // The first tile on the path
+    int lastTile = getTileFromWorldPoint(dest);  // The last tile on the path
 
     // All tiles used to create the path must be route nodes
     // If the end points aren't route nodes, then they must be ramp nodes (otherwise the point is on a wall tile or out of the map)
     // Ramp nodes contain all accessible route nodes
 
-    // Modify the last tile's to be it's nearest route node (sorted list)
+    // Modify the last tile's to be it's nearest route node that the agent fits through (sorted list)
     if (mRampGraph.count(lastTile) == 1)
-        lastTile = mRampGraph.at(lastTile)[0];
+    {
+        auto& rampEdges = mRampGraph.at(lastTile);
+        auto nearest = find_if(rampEdges.begin(), rampEdges.end(), [agentRadius](const GraphEdge& edge) { return edge.mClearance >= agentRadius; });
+        
+        // No route node is reachable for an agent this size
+        if (nearest == rampEdges.end())
+            return false;
+
+        lastTile = nearest->mNode;
+    }
+
+    // Each thread reuses its own search memory
+    thread_local PathSearch search;
+    search.mNodes.clear();
+    search.mClosedSet.clear();
+
+    auto& nodes = search.mNodes;
+    auto heapComp = [&nodes](int op2, int op1) { return higherPotential(nodes.at(op2), nodes.at(op1)); };
 
     // Open set
-    std::vector<Tile*> openSet;
+    std::vector<int>& openSet = search.mOpenSet;
+    openSet.clear();
     openSet.reserve(30);    // 30 is a tested number
-    make_heap(openSet.begin(), openSet.end(), heapComp);
 
     // Closed set
-    std::unordered_set<Tile*> closedSet;
+    std::unordered_set<int>& closedSet = search.mClosedSet;
 
     // If the first tile is a ramp node, add its neighbours to the open set
     if (mRampGraph.count(firstTile) == 1)
-        useRamp(openSet, closedSet, firstTile, lastTile);
+        useRamp(search, firstTile, lastTile, agentRadius);
     else
     {
         // Start a new path
-        mRouteGraph.at(firstTile).reset();
+        nodes[firstTile].reset();
 
         // Add the starting node to the open set
         openSet.push_back(firstTile);
@@ -399,7 +325,7 @@ bool Pathfinder::findPath(const Vec& startPoint, const Vec& dest, std::stack<SDL
 
     while (openSet.size() > 0)
     {
-        Tile* currentTile = openSet[0];
+        int currentTile = openSet[0];
         // Remove the newly explored tile from the open set   
         pop_heap(openSet.begin(), openSet.end(), heapComp);
         openSet.pop_back();
@@ -411,7 +337,7 @@ bool Pathfinder::findPath(const Vec& startPoint, const Vec& dest, std::stack<SDL
         if (currentTile == lastTile)
         {
             // Backtrack the linked list and create a list of points
-            createPath(lastTile, path);
+            createPath(search, lastTile, path);
             return true;
         }
         /*Heap test
@@ -419,20 +345,27 @@ bool Pathfinder::findPath(const Vec& startPoint, const Vec& dest, std::stack<SDL
             // printf("|%d| ", openSet[i]->getFcost());
         printf("\n");*/
 
-        for (auto neighbour : mRouteGraph.at(currentTile).mNeighbours)
+        for (auto& edge : mRouteGraph.at(currentTile))
         {
+            // Skip edges that are too narrow for the agent
+            if (edge.mClearance < agentRadius)
+                continue;
+
+            int neighbour = edge.mNode;
+
             // If neighbour is already closed, skip
             if (closedSet.find(neighbour) != closedSet.end())
                 continue;
 
-            int newCostToNeighbour = mRouteGraph.at(currentTile).mGcost + getDistance(currentTile, neighbour);
+            int newCostToNeighbour = nodes.at(currentTile).mGcost + getDistance(currentTile, neighbour);
             bool neighbourIsOpen = find(openSet.begin(), openSet.end(), neighbour) != openSet.end();
             // If the neighbour is not in the open set or the new cost is cheaper
-            if (!neighbourIsOpen || newCostToNeighbour < mRouteGraph.at(neighbour).mGcost)
+            if (!neighbourIsOpen || newCostToNeighbour < nodes.at(neighbour).mGcost)
             {
-                mRouteGraph.at(neighbour).mGcost = newCostToNeighbour;
-                mRouteGraph.at(neighbour).mHcost = getDistance(neighbour, lastTile);
-                mRouteGraph.at(neighbour).mParent = currentTile;
+                NodeInfo& node = nodes[neighbour];
+                node.mGcost = newCostToNeighbour;
+                node.mHcost = getDistance(neighbour, lastTile);
+                node.mParent = currentTile;
                 if (!neighbourIsOpen)
                 {
                     openSet.push_back(neighbour);
@@ -444,19 +377,29 @@ bool Pathfinder::findPath(const Vec& startPoint, const Vec& dest, std::stack<SDL
     return false;
 }
 
-void Pathfinder::useRamp(std::vector<Tile*>& openSet, std::unordered_set<Tile*>& closedSet, Tile* firstTile, Tile* lastTile)
+void Pathfinder::useRamp(PathSearch& search, int firstTile, int lastTile, float agentRadius) const
 {
+    auto& nodes = search.mNodes;
+    auto heapComp = [&nodes](int op2, int op1) { return higherPotential(nodes.at(op2), nodes.at(op1)); };
+
     // Add the first tile to the closed set
-    closedSet.insert(firstTile);
+    search.mClosedSet.insert(firstTile);
 
     // Add the first tile's neighbours to the open set
-    for (auto neighbour : mRampGraph.at(firstTile))
+    for (auto& edge : mRampGraph.at(firstTile))
     {
-        mRouteGraph.at(neighbour).mGcost = getDistance(firstTile, neighbour);
-        mRouteGraph.at(neighbour).mHcost = getDistance(neighbour, lastTile);
-        mRouteGraph.at(neighbour).mParent = firstTile;
+        // Skip edges that are too narrow for the agent
+        if (edge.mClearance < agentRadius)
+            continue;
 
-        openSet.push_back(neighbour);
-        push_heap(openSet.begin(), openSet.end(), heapComp);
+        int neighbour = edge.mNode;
+
+        NodeInfo& node = nodes[neighbour];
+        node.mGcost = getDistance(firstTile, neighbour);
+        node.mHcost = getDistance(neighbour, lastTile);
+        node.mParent = firstTile;
+
+        search.mOpenSet.push_back(neighbour);
+        push_heap(search.mOpenSet.begin(), search.mOpenSet.end(), heapComp);
     }
 }
\ No newline at end of file
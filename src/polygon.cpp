@@ -411,29 +411,28 @@ Vec ConvexPolygon::resolveCollisions(const ConvexPolygon& moveableShape, const s
 {
     Vec totalSolution{ 0.f,0.f };
 
-    for (auto iFixedShape : fixedShapes)
+    // Get every collision solution between the moveable and fixed shapes
+    for (auto& iFixedShape : fixedShapes)
+        addToSolution(resolveCollision(moveableShape, iFixedShape), totalSolution);
+
+    return totalSolution;
+}
+
+void ConvexPolygon::addToSolution(const Vec& solution, Vec& totalSolution)
+{
+    if (solution.isZeroVector())    // ignore trivial solutions
+        return;
+    else if (totalSolution.isZeroVector())   // Initialize the overall solution variable to a non-zero vector
+        totalSolution = solution;
+    else if (solution * totalSolution <= 0)     // If the vector is in the perpendicular or in the opposite direction, just sum it
+        totalSolution += solution;
+    else   // This this iteration's solution to the total, but only extra direction/magnitude
     {
-        // Get every collision solution between the moveable and fixed shapes
-        Vec solution{ resolveCollision(moveableShape, iFixedShape) };
-        
-        if (solution.isZeroVector())    // ignore trivial solutions
-            continue;
-        else if (totalSolution.isZeroVector())   // Initialize the overall solution variable to a non-zero vector
-            totalSolution = solution;
-        else if (solution * totalSolution <= 0)     // If the vector is in the perpendicular or in the opposite direction, just sum it
-        {
-            totalSolution += solution;
-            continue;
-        }
-        else   // This this iteration's solution to the total, but only extra direction/magnitude
-        {
-            float duplicate = solution.scalarProjectOn(totalSolution);  // Get the common direction between the current solution and the total
-            duplicate /= totalSolution.getMagnitude();                  // Make duplicate a ratio of the solution
-            duplicate = std::min(duplicate, 1.f);                       // Cap the duplicate ratio to its own length
-            totalSolution += solution - (duplicate * totalSolution);    // Subtract the duplicate vector from the current solution, and add it to the total
-        }
+        float duplicate = solution.scalarProjectOn(totalSolution);  // Get the common direction between the current solution and the total
+        duplicate /= totalSolution.getMagnitude();                  // Make duplicate a ratio of the solution
+        duplicate = std::min(duplicate, 1.f);                       // Cap the duplicate ratio to its own length
+        totalSolution += solution - (duplicate * totalSolution);    // Subtract the duplicate vector from the current solution, and add it to the total
     }
-    return totalSolution;
 }
 
 // Use seperating axis theorm to find a resolution vector
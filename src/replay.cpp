@@ -0,0 +1,159 @@
+#include "../header/replay.h"
+#include "../header/world.h"
+#include "../header/components/mechanical_component.h"
+
+#include <SDL.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+// FNV-1a, applied a 32 bit word at a time rather than a byte at a time
+#define HASH_OFFSET_BASIS 14695981039346656037ull
+#define HASH_PRIME 1099511628211ull
+
+
+namespace
+{
+    void addToHash(std::uint64_t& hash, std::uint32_t word)
+    {
+        hash = (hash ^ word) * HASH_PRIME;
+    }
+
+    void addToHash(std::uint64_t& hash, float value)
+    {
+        std::uint32_t word;
+        std::memcpy(&word, &value, sizeof(word));
+        addToHash(hash, word);
+    }
+}
+
+namespace ReplayFormat
+{
+    std::uint64_t hashWorld(World& world)
+    {
+        std::uint64_t hash = HASH_OFFSET_BASIS;
+        world.eachWithHandle<MechanicalComponent>([&hash](EntityHandle handle, MechanicalComponent& mechComp)
+            {
+                addToHash(hash, static_cast<std::uint32_t>(handle.getId()));
+                addToHash(hash, mechComp.getPos().getX());
+                addToHash(hash, mechComp.getPos().getY());
+                addToHash(hash, mechComp.getVel().getX());
+                addToHash(hash, mechComp.getVel().getY());
+            });
+        return hash;
+    }
+}
+
+InputRecorder::InputRecorder(const std::string& path) : mPath{ path } {}
+
+bool InputRecorder::isRecorded(const SDL_Event& event)
+{
+    return (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) && event.key.repeat == 0;
+}
+
+void InputRecorder::recordEvent(const SDL_Event& event, int tick)
+{
+    mEvents.push_back(ReplayFormat::Event{ static_cast<std::uint32_t>(tick), event.type, static_cast<std::int32_t>(event.key.keysym.sym) });
+}
+
+void InputRecorder::recordTick(std::uint64_t stateHash)
+{
+    mHashes.push_back(stateHash);
+}
+
+bool InputRecorder::save(float tickLength) const
+{
+    ReplayFormat::Header header{};
+    std::memcpy(header.mMagic, ReplayFormat::MAGIC, sizeof(ReplayFormat::MAGIC));
+    header.mVersion = ReplayFormat::VERSION;
+    header.mTickLength = tickLength;
+    header.mTickCount = static_cast<std::uint32_t>(mHashes.size());
+    header.mEventCount = static_cast<std::uint32_t>(mEvents.size());
+
+    std::ofstream output{ mPath, std::ios::binary | std::ios::trunc };
+    if (output.is_open() == false)
+    {
+        fprintf(stderr, "Unable to open %s for writing\n", mPath.c_str());
+        return false;
+    }
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    output.write(reinterpret_cast<const char*>(mEvents.data()), static_cast<std::streamsize>(mEvents.size() * sizeof(ReplayFormat::Event)));
+    output.write(reinterpret_cast<const char*>(mHashes.data()), static_cast<std::streamsize>(mHashes.size() * sizeof(std::uint64_t)));
+
+    if (output.good() == false)
+    {
+        fprintf(stderr, "Failed to write replay: write unsuccessful\n");
+        return false;
+    }
+    return true;
+}
+
+bool InputReplay::load(const std::string& path)
+{
+    std::ifstream input{ path, std::ios::binary };
+    if (input.is_open() == false)
+    {
+        fprintf(stderr, "Unable to load replay file %s\n", path.c_str());
+        return false;
+    }
+
+    std::vector<char> data{ std::istreambuf_iterator<char>{ input }, std::istreambuf_iterator<char>{} };
+
+    // Not a replay, or written by an incompatible version
+    ReplayFormat::Header header;
+    if (data.size() < sizeof(header))
+    {
+        fprintf(stderr, "Failed to load replay: %s is too short\n", path.c_str());
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+    if (std::memcmp(header.mMagic, ReplayFormat::MAGIC, sizeof(ReplayFormat::MAGIC)) != 0 || header.mVersion != ReplayFormat::VERSION)
+    {
+        fprintf(stderr, "Failed to load replay: %s isn't a replay of this version\n", path.c_str());
+        return false;
+    }
+
+    std::size_t eventsSize = static_cast<std::size_t>(header.mEventCount) * sizeof(ReplayFormat::Event);
+    std::size_t hashesSize = static_cast<std::size_t>(header.mTickCount) * sizeof(std::uint64_t);
+    if (data.size() != sizeof(header) + eventsSize + hashesSize || !(header.mTickLength > 0.f))
+    {
+        fprintf(stderr, "Failed to load replay: %s is corrupt\n", path.c_str());
+        return false;
+    }
+
+    mTickLength = header.mTickLength;
+    mEvents.resize(header.mEventCount);
+    mHashes.resize(header.mTickCount);
+    std::memcpy(mEvents.data(), data.data() + sizeof(header), eventsSize);
+    std::memcpy(mHashes.data(), data.data() + sizeof(header) + eventsSize, hashesSize);
+
+    mNextEvent = 0;
+    mDivergedTick = -1;
+    return true;
+}
+
+bool InputReplay::checkTick(int tick, std::uint64_t stateHash)
+{
+    if (tick >= getTickCount() || mHashes[tick] == stateHash)
+        return true;
+
+    if (mDivergedTick == -1)
+        mDivergedTick = tick;
+    return false;
+}
+
+SDL_Event InputReplay::toSdlEvent(const ReplayFormat::Event& event)
+{
+    SDL_Event sdlEvent{};
+    sdlEvent.type = event.mType;
+    sdlEvent.key.state = event.mType == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+    sdlEvent.key.repeat = 0;
+    sdlEvent.key.keysym.sym = static_cast<SDL_Keycode>(event.mKey);
+    return sdlEvent;
+}
@@ -0,0 +1,159 @@
+#include "../header/spatial_grid.h"
+#include "../header/world.h"
+#include "../header/components/mechanical_component.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+// The table has atleast this many buckets per entity, so few cells share a bucket
+#define BUCKETS_PER_ENTITY 2
+#define MIN_BUCKETS 64
+
+
+SpatialGrid::SpatialGrid(float cellSize) : mCellSize{ cellSize }, mInverseCellSize{ 1.f / cellSize }
+{
+    mBucketStarts.assign(MIN_BUCKETS + 1, 0);
+    mBucketMask = MIN_BUCKETS - 1;
+}
+
+void SpatialGrid::rebuild(World& world)
+{
+    mUnsorted.clear();
+    mMaxHalfWidth = 0.f;
+    mMaxHalfHeight = 0.f;
+    mFirstCellX = mFirstCellY = std::numeric_limits<int>::max();
+    mLastCellX = mLastCellY = std::numeric_limits<int>::min();
+
+    world.eachWithHandle<MechanicalComponent>([this](EntityHandle handle, MechanicalComponent& mechComp)
+        {
+            const SDL_FRect& box = mechComp.getCollisionBox();
+            Vec centre{ box.x + box.w / 2.f, box.y + box.h / 2.f };
+            int cellX = getCell(centre.getX());
+            int cellY = getCell(centre.getY());
+
+            mUnsorted.push_back(Entry{ handle, box, centre, cellX, cellY });
+
+            mMaxHalfWidth = std::max(mMaxHalfWidth, box.w / 2.f);
+            mMaxHalfHeight = std::max(mMaxHalfHeight, box.h / 2.f);
+            mFirstCellX = std::min(mFirstCellX, cellX);
+            mFirstCellY = std::min(mFirstCellY, cellY);
+            mLastCellX = std::max(mLastCellX, cellX);
+            mLastCellY = std::max(mLastCellY, cellY);
+        });
+
+    // Power of 2 buckets so a bucket is found with a mask
+    int bucketCount = MIN_BUCKETS;
+    while (bucketCount < static_cast<int>(mUnsorted.size()) * BUCKETS_PER_ENTITY)
+        bucketCount *= 2;
+    mBucketMask = static_cast<Uint32>(bucketCount - 1);
+
+    // Counting sort by bucket, count each bucket's entries, then each bucket starts where the ones before it end
+    mBucketStarts.assign(bucketCount + 1, 0);
+    mUnsortedBuckets.resize(mUnsorted.size());
+    for (size_t iEntry = 0; iEntry < mUnsorted.size(); ++iEntry)
+    {
+        mUnsortedBuckets[iEntry] = getBucket(mUnsorted[iEntry].mCellX, mUnsorted[iEntry].mCellY);
+        ++mBucketStarts[mUnsortedBuckets[iEntry] + 1];
+    }
+
+    for (int iBucket = 0; iBucket < bucketCount; ++iBucket)
+        mBucketStarts[iBucket + 1] += mBucketStarts[iBucket];
+
+    // Each bucket's start is moved up as it's filled, then moved back
+    mEntries.resize(mUnsorted.size());
+    for (size_t iEntry = 0; iEntry < mUnsorted.size(); ++iEntry)
+        mEntries[mBucketStarts[mUnsortedBuckets[iEntry]]++] = mUnsorted[iEntry];
+
+    for (int iBucket = bucketCount; iBucket > 0; --iBucket)
+        mBucketStarts[iBucket] = mBucketStarts[iBucket - 1];
+    mBucketStarts[0] = 0;
+}
+
+int SpatialGrid::queryRadius(const Vec& centre, float radius, EntityHandle* results, int maxResults) const
+{
+    int count = 0;
+    forEachInRadius(centre, radius, [results, maxResults, &count](const Entry& entry)
+        {
+            if (count < maxResults)
+                results[count] = entry.mHandle;
+            ++count;
+        });
+    return count;
+}
+
+int SpatialGrid::queryBox(const SDL_FRect& area, EntityHandle* results, int maxResults) const
+{
+    int count = 0;
+    forEachInBox(area, [results, maxResults, &count](const Entry& entry)
+        {
+            if (count < maxResults)
+                results[count] = entry.mHandle;
+            ++count;
+        });
+    return count;
+}
+
+int SpatialGrid::findNearest(const Vec& point, int k, Neighbour* results, float maxDistance, EntityHandle exclude) const
+{
+    if (k <= 0 || mEntries.empty())
+        return 0;
+
+    // Squared distances while searching
+    int count = 0;
+    float maxDistanceSquared = maxDistance * maxDistance;
+
+    auto consider = [&](const Entry& entry)
+    {
+        if (entry.mHandle == exclude)
+            return;
+
+        float deltaX = entry.mCentre.getX() - point.getX();
+        float deltaY = entry.mCentre.getY() - point.getY();
+        float distanceSquared = deltaX * deltaX + deltaY * deltaY;
+        if (distanceSquared > maxDistanceSquared || (count == k && distanceSquared >= results[k - 1].mDistance))
+            return;
+
+        // Insertion into the sorted results, the furthest falls off the end once there are k
+        int iSlot = count < k ? count++ : k - 1;
+        while (iSlot > 0 && results[iSlot - 1].mDistance > distanceSquared)
+        {
+            results[iSlot] = results[iSlot - 1];
+            --iSlot;
+        }
+        results[iSlot] = Neighbour{ entry.mHandle, entry.mCentre, distanceSquared };
+    };
+
+    // Search rings of cells around the point's cell, outwards
+    // Cells in ring r + 1 are atleast r cells away from any point in the centre cell
+    int centreX = getCell(point.getX());
+    int centreY = getCell(point.getY());
+
+    for (int ring = 0;; ++ring)
+    {
+        if (ring == 0)
+            forEachInCells(centreX, centreY, centreX, centreY, consider);
+        else
+        {
+            // Top and bottom rows, then the sides between them
+            forEachInCells(centreX - ring, centreY - ring, centreX + ring, centreY - ring, consider);
+            forEachInCells(centreX - ring, centreY + ring, centreX + ring, centreY + ring, consider);
+            forEachInCells(centreX - ring, centreY - ring + 1, centreX - ring, centreY + ring - 1, consider);
+            forEachInCells(centreX + ring, centreY - ring + 1, centreX + ring, centreY + ring - 1, consider);
+        }
+
+        float searched = static_cast<float>(ring) * mCellSize;
+        bool foundAll = count == k && results[k - 1].mDistance <= searched * searched;
+        bool pastMaxDistance = searched > maxDistance;
+        bool pastEntities = centreX - ring <= mFirstCellX && centreY - ring <= mFirstCellY && centreX + ring >= mLastCellX && centreY + ring >= mLastCellY;
+
+        if (foundAll || pastMaxDistance || pastEntities)
+            break;
+    }
+
+    for (int iResult = 0; iResult < count; ++iResult)
+        results[iResult].mDistance = sqrtf(results[iResult].mDistance);
+
+    return count;
+}
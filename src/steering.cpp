@@ -0,0 +1,214 @@
+#include "../header/steering.h"
+#include "../header/vec.h"
+#include "../header/spatial_grid.h"
+#include "../header/world.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+// Only SSE2 is used, the exponent tricks need integer vectors that AVX doesn't have at 256 bits
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define STEERING_SSE2
+#endif
+
+// log2(m) = 2 / ln(2) * (t + t^3 / 3 + t^5 / 5 + t^7 / 7), t = (m - 1) / (m + 1)
+// m is kept in [sqrt(0.5), sqrt(2)), so |t| < 0.172 and the next term is below 1e-7
+#define LOG2_SPLIT 1.41421356f
+#define LOG2_C1 2.88539008f
+#define LOG2_C3 0.961796694f
+#define LOG2_C5 0.577078016f
+#define LOG2_C7 0.412198583f
+
+// 2^f = e^(f ln(2)) as a Taylor series, f is kept in [-0.5, 0.5] so the next term is below 1e-7
+#define EXP2_C1 0.693147181f
+#define EXP2_C2 0.240226507f
+#define EXP2_C3 0.0555041087f
+#define EXP2_C4 0.00961812911f
+#define EXP2_C5 0.00133335581f
+#define EXP2_C6 0.000154035304f
+
+// Past these, 2^y doesn't fit in a normal float
+#define EXP2_MIN -126.f
+#define EXP2_MAX 127.f
+
+
+namespace
+{
+    float fastLog2(float x)
+    {
+        std::uint32_t bits;
+        std::memcpy(&bits, &x, sizeof(bits));
+
+        // x = m * 2^exponent, m in [1, 2)
+        float exponent = static_cast<float>(static_cast<int>(bits >> 23) - 127);
+        bits = (bits & 0x007FFFFF) | 0x3F800000;
+        float m;
+        std::memcpy(&m, &bits, sizeof(m));
+
+        if (m > LOG2_SPLIT)
+        {
+            m *= 0.5f;
+            exponent += 1.f;
+        }
+
+        float t = (m - 1.f) / (m + 1.f);
+        float t2 = t * t;
+        return exponent + t * (LOG2_C1 + t2 * (LOG2_C3 + t2 * (LOG2_C5 + t2 * LOG2_C7)));
+    }
+
+    float fastExp2(float y)
+    {
+        y = std::clamp(y, EXP2_MIN, EXP2_MAX);
+
+        // 2^y = 2^whole * 2^f
+        float whole = std::nearbyint(y);
+        float f = y - whole;
+        float p = 1.f + f * (EXP2_C1 + f * (EXP2_C2 + f * (EXP2_C3 + f * (EXP2_C4 + f * (EXP2_C5 + f * EXP2_C6)))));
+
+        std::uint32_t bits = static_cast<std::uint32_t>(static_cast<int>(whole) + 127) << 23;
+        float scale;
+        std::memcpy(&scale, &bits, sizeof(scale));
+        return p * scale;
+    }
+
+#if defined(STEERING_SSE2)
+    // Same steps as fastLog2, 4 at a time
+    __m128 fastLog2(__m128 x)
+    {
+        __m128i bits = _mm_castps_si128(x);
+        __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+        __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+
+        __m128 high = _mm_cmpgt_ps(m, _mm_set1_ps(LOG2_SPLIT));
+        m = _mm_or_ps(_mm_and_ps(high, _mm_mul_ps(m, _mm_set1_ps(0.5f))), _mm_andnot_ps(high, m));
+        exponent = _mm_add_ps(exponent, _mm_and_ps(high, _mm_set1_ps(1.f)));
+
+        __m128 one = _mm_set1_ps(1.f);
+        __m128 t = _mm_div_ps(_mm_sub_ps(m, one), _mm_add_ps(m, one));
+        __m128 t2 = _mm_mul_ps(t, t);
+        __m128 series = _mm_add_ps(_mm_set1_ps(LOG2_C5), _mm_mul_ps(t2, _mm_set1_ps(LOG2_C7)));
+        series = _mm_add_ps(_mm_set1_ps(LOG2_C3), _mm_mul_ps(t2, series));
+        series = _mm_add_ps(_mm_set1_ps(LOG2_C1), _mm_mul_ps(t2, series));
+        return _mm_add_ps(exponent, _mm_mul_ps(t, series));
+    }
+
+    // Same steps as fastExp2, 4 at a time
+    __m128 fastExp2(__m128 y)
+    {
+        y = _mm_min_ps(_mm_max_ps(y, _mm_set1_ps(EXP2_MIN)), _mm_set1_ps(EXP2_MAX));
+
+        // Converting rounds to the nearest integer, like nearbyint
+        __m128i whole = _mm_cvtps_epi32(y);
+        __m128 f = _mm_sub_ps(y, _mm_cvtepi32_ps(whole));
+
+        __m128 p = _mm_add_ps(_mm_set1_ps(EXP2_C5), _mm_mul_ps(f, _mm_set1_ps(EXP2_C6)));
+        p = _mm_add_ps(_mm_set1_ps(EXP2_C4), _mm_mul_ps(f, p));
+        p = _mm_add_ps(_mm_set1_ps(EXP2_C3), _mm_mul_ps(f, p));
+        p = _mm_add_ps(_mm_set1_ps(EXP2_C2), _mm_mul_ps(f, p));
+        p = _mm_add_ps(_mm_set1_ps(EXP2_C1), _mm_mul_ps(f, p));
+        p = _mm_add_ps(_mm_set1_ps(1.f), _mm_mul_ps(f, p));
+
+        __m128 scale = _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(whole, _mm_set1_epi32(127)), 23));
+        return _mm_mul_ps(p, scale);
+    }
+#endif
+}
+
+namespace Steering
+{
+    Vec getDirection(const Vec& displacement)
+    {
+        float length = sqrtf(displacement * displacement);
+        if (length == 0.f)
+            return Vec{ 1.f, 0.f };
+
+        return displacement / length;
+    }
+
+    Vec getDrag(const Vec& vel, float exponent, float cap)
+    {
+        if (vel.isZeroVector())
+            return Vec{ 0.f, 0.f };
+
+        // Cap the drag (cap must be greater than the acceleration to avoid being completely canceled)
+        float dragMagnitude = std::min(powf(vel.getMagnitude(), exponent), cap);
+
+        // Opposite direction to the velocity
+        Vec drag{ vel * -1.f };
+        drag.normalize();
+        drag *= dragMagnitude;
+        return drag;
+    }
+
+    float fastPow(float base, float exponent)
+    {
+        return fastExp2(exponent * fastLog2(base));
+    }
+
+    void addDrag(const float* velX, const float* velY, const float* dragExponent, const float* dragCap, float* accelX, float* accelY, int count)
+    {
+        int i = 0;
+
+#if defined(STEERING_SSE2)
+        const __m128 zero = _mm_setzero_ps();
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 vx = _mm_loadu_ps(velX + i);
+            __m128 vy = _mm_loadu_ps(velY + i);
+
+            // Lanes that aren't moving have no drag, and would take the log of 0
+            __m128 speedSquared = _mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy));
+            __m128 moving = _mm_cmpgt_ps(speedSquared, zero);
+            __m128 speed = _mm_sqrt_ps(_mm_or_ps(_mm_and_ps(moving, speedSquared), _mm_andnot_ps(moving, _mm_set1_ps(1.f))));
+
+            __m128 dragMagnitude = _mm_min_ps(fastExp2(_mm_mul_ps(_mm_loadu_ps(dragExponent + i), fastLog2(speed))), _mm_loadu_ps(dragCap + i));
+            __m128 scale = _mm_and_ps(moving, _mm_div_ps(dragMagnitude, speed));
+
+            _mm_storeu_ps(accelX + i, _mm_sub_ps(_mm_loadu_ps(accelX + i), _mm_mul_ps(vx, scale)));
+            _mm_storeu_ps(accelY + i, _mm_sub_ps(_mm_loadu_ps(accelY + i), _mm_mul_ps(vy, scale)));
+        }
+#endif
+
+        // Same steps one at a time for what's left over
+        for (; i < count; ++i)
+        {
+            float speedSquared = velX[i] * velX[i] + velY[i] * velY[i];
+            if (!(speedSquared > 0.f))
+                continue;
+
+            float speed = sqrtf(speedSquared);
+            float scale = std::min(fastPow(speed, dragExponent[i]), dragCap[i]) / speed;
+            accelX[i] -= velX[i] * scale;
+            accelY[i] -= velY[i] * scale;
+        }
+    }
+
+    Vec getSeparation(const SpatialGrid& grid, const Vec& centre, float radius, EntityHandle self)
+    {
+        SpatialGrid::Neighbour neighbours[SEPARATION_NEIGHBOURS];
+        int count = grid.findNearest(centre, SEPARATION_NEIGHBOURS, neighbours, radius, self);
+
+        Vec push{ 0.f, 0.f };
+        for (int iNeighbour = 0; iNeighbour < count; ++iNeighbour)
+        {
+            const SpatialGrid::Neighbour& neighbour = neighbours[iNeighbour];
+
+            // Entities on top of each other are split by id, so they go opposite ways
+            Vec away{ self.getId() < neighbour.mHandle.getId() ? -1.f : 1.f, 0.f };
+            if (neighbour.mDistance > 0.f)
+                away = (centre - neighbour.mCentre) / neighbour.mDistance;
+
+            push += away * (1.f - neighbour.mDistance / radius);
+        }
+
+        float length = sqrtf(push * push);
+        if (length > 1.f)
+            push /= length;
+
+        return push;
+    }
+}
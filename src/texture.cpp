@@ -10,46 +10,72 @@
 
 
 Texture::Texture(SDL_Renderer* defaultRenderer, std::string pathOrText, TTF_Font* defaultFont, SDL_Color* textColor)
+	: mSource{ std::move(pathOrText) }, mDefaultRenderer{ defaultRenderer }, mDefaultFont{ defaultFont }
 {
-	mDefaultRenderer = defaultRenderer;
-	mDefaultFont = defaultFont;
-
 	// If font is provided, text texture is assumed
-	if (defaultFont == nullptr)
-	{
-		if (loadTexture(pathOrText) == false)
-			exit(-1);
-	}
-	else
-	{
-		if(loadTextTexture(pathOrText, *textColor) == false)
-			exit(-1);
-	}
-
-	// Get texture dimensions
-	if (SDL_QueryTexture(mTexture.get(), nullptr, nullptr, &mWidth, &mHeight) != 0)
-	{ 
-		fprintf(stderr, "%s", SDL_GetError());
-		exit(-1);
-	}
+	if (defaultFont != nullptr)
+		mTextColor = *textColor;
 }
 
 Texture::Texture(Texture&& texture) noexcept
-	: mWidth{ texture.mWidth }, mHeight{ texture.mHeight }, mTexture{ std::move(texture.mTexture) }, mDefaultRenderer{ texture.mDefaultRenderer }, mDefaultFont{ texture.mDefaultFont }
+	: mTexture{ std::move(texture.mTexture) }, mWidth{ texture.mWidth }, mHeight{ texture.mHeight }, mSource{ std::move(texture.mSource) }, mTextColor{ texture.mTextColor },
+	mLoaded{ texture.mLoaded }, mDefaultRenderer{ texture.mDefaultRenderer }, mDefaultFont{ texture.mDefaultFont }
 {
 	// Reset passed in texture
 	texture.mWidth = 0;
 	texture.mHeight = 0;
+	texture.mLoaded = false;
 	texture.mDefaultRenderer = nullptr;
 	texture.mDefaultFont = nullptr;
 }
 
-// Load texture from file
-bool Texture::loadTexture(std::string path)
+bool Texture::ensureLoaded() const
+{
+	if (mLoaded)
+		return mTexture != nullptr;
+
+	// Nothing to load with, e.g. when running headless
+	if (mDefaultRenderer == nullptr)
+		return false;
+
+	// Failing to load an asset is fatal, same as when textures were loaded up front
+	mLoaded = true;
+	if (loadSource() == false)
+		exit(-1);
+
+	return true;
+}
+
+bool Texture::loadSource() const
 {
-	// Create new texture
-	mTexture.reset(IMG_LoadTexture(mDefaultRenderer, path.c_str()));
+	// Create new texture, if font is provided, text texture is assumed
+	if (mDefaultFont == nullptr)
+		mTexture.reset(IMG_LoadTexture(mDefaultRenderer, mSource.c_str()));
+	else
+	{
+		// Create surface
+		SDL_Surface* textSurface = TTF_RenderText_Blended(mDefaultFont, mSource.c_str(), mTextColor);
+		if (textSurface == nullptr)
+		{
+			fprintf(stderr, "%s", TTF_GetError());
+			return false;
+		}
+
+		// Create texture from surface
+		mTexture.reset(SDL_CreateTextureFromSurface(mDefaultRenderer, textSurface));
+
+		// Free surface
+		SDL_FreeSurface(textSurface);
+	}
+
 	if (mTexture == nullptr)
+	{
+		fprintf(stderr, "%s", SDL_GetError());
+		return false;
+	}
+
+	// Get texture dimensions
+	if (SDL_QueryTexture(mTexture.get(), nullptr, nullptr, &mWidth, &mHeight) != 0)
 	{ 
 		fprintf(stderr, "%s", SDL_GetError());
 		return false;
@@ -58,35 +84,40 @@ bool Texture::loadTexture(std::string path)
 	return true;
 }
 
+// Load texture from file
+bool Texture::loadTexture(std::string path)
+{
+	mSource = std::move(path);
+	mDefaultFont = nullptr;
+
+	// Loaded straight away if there's a renderer, so a bad path is reported here
+	mLoaded = mDefaultRenderer != nullptr;
+	return !mLoaded || loadSource();
+}
+
 // Loads texture from text
 bool Texture::loadTextTexture(std::string textureText, SDL_Color textColor)
 {
-	// Create surface
-	SDL_Surface* textSurface = TTF_RenderText_Blended(mDefaultFont, textureText.c_str(), textColor);
-	if (textSurface == nullptr)
+	// Text needs the font the texture was created with
+	if (mDefaultFont == nullptr)
 	{
-		fprintf(stderr, "%s", TTF_GetError());
+		fprintf(stderr, "Error: Attempted to load text into a texture without a font\n");
 		return false;
 	}
 
-	// Create texture from surface
-	mTexture.reset(SDL_CreateTextureFromSurface(mDefaultRenderer, textSurface));
-
-	// Free surface
-	SDL_FreeSurface(textSurface);
-
-	if (mTexture == nullptr)
-	{
-		fprintf(stderr, "%s", SDL_GetError());
-		return false;
-	}
+	mSource = std::move(textureText);
+	mTextColor = textColor;
 
-	return true;
+	mLoaded = mDefaultRenderer != nullptr;
+	return !mLoaded || loadSource();
 }
 
 // Set color modulation
 bool Texture::setColorModulation(Uint8 red, Uint8 green, Uint8 blue)
 {
+	if (!ensureLoaded())
+		return false;
+
 	if (SDL_SetTextureColorMod(mTexture.get(), red, green, blue) != 0)
 	{
 		fprintf(stderr, "%s", SDL_GetError());
@@ -99,6 +130,9 @@ bool Texture::setColorModulation(Uint8 red, Uint8 green, Uint8 blue)
 // Set texture blend mode
 bool Texture::setBlendMode(SDL_BlendMode blending)
 {
+	if (!ensureLoaded())
+		return false;
+
 	if (SDL_SetTextureBlendMode(mTexture.get(), blending) != 0)
 	{
 		fprintf(stderr, "%s", SDL_GetError());
@@ -111,6 +145,9 @@ bool Texture::setBlendMode(SDL_BlendMode blending)
 // Set transparency
 bool Texture::setTransparency(Uint8 alpha)
 {
+	if (!ensureLoaded())
+		return false;
+
 	if (SDL_SetTextureAlphaMod(mTexture.get(), alpha) != 0)
 	{
 		fprintf(stderr, "%s", SDL_GetError());
@@ -123,6 +160,9 @@ bool Texture::setTransparency(Uint8 alpha)
 // Draws texture at given point
 bool Texture::draw(int x, int y, const SDL_Rect* crop, double angle, SDL_Point* center, SDL_RendererFlip flip)
 {
+	if (!ensureLoaded())
+		return false;
+
 	// Set drawing area
 	SDL_Rect renderArea{ x, y, mWidth, mHeight };
 
@@ -167,8 +207,31 @@ bool Texture::draw(int x, int y, const SDL_Rect* crop, double angle, SDL_Point*
 	return true;
 }
 
+// Draws textured triangles
+bool Texture::drawGeometry(const SDL_Vertex* vertices, int vertexCount, const int* indices, int indexCount)
+{
+	if (!ensureLoaded())
+		return false;
+
+	if (SDL_RenderGeometry(mDefaultRenderer, mTexture.get(), vertices, vertexCount, indices, indexCount) != 0)
+	{
+		fprintf(stderr, "%s", SDL_GetError());
+		return false;
+	}
+
+	return true;
+}
+
 // Get texture width
-int Texture::getWidth() const{	return mWidth;	}
+int Texture::getWidth() const
+{
+	ensureLoaded();
+	return mWidth;
+}
 
 // Get texture height
-int Texture::getHeight() const{	return mHeight;	}
\ No newline at end of file
+int Texture::getHeight() const
+{
+	ensureLoaded();
+	return mHeight;
+}
\ No newline at end of file
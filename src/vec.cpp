@@ -27,16 +27,6 @@ float Vec::operator[](int row) const
 }
 
 // Getters
-float Vec::getX() const
-{
-	return mX;
-}
-
-float Vec::getY() const
-{
-	return mY;
-}
-
 bool Vec::isZeroVector() const
 {
 	if (mX == 0 && mY == 0)
@@ -44,17 +34,6 @@ bool Vec::isZeroVector() const
 	return false;
 }
 
-// Setters
-void Vec::setX(float xValue)
-{
-	mX = xValue;
-}
-
-void Vec::setY(float yValue)
-{
-	mY = yValue;
-}
-
 // Vector by vector operations
 float Vec::operator*(const Vec& vec) const    // Dot product
 {
@@ -0,0 +1,220 @@
+#include "../header/wall_geometry.h"
+#include "../header/map.h"
+#include "../header/polygon.h"
+#include "../header/vec.h"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <vector>
+
+
+using namespace MapInternals;
+
+namespace
+{
+    // The sides of a tile, in the order an outline goes around a lone wall tile
+    enum Side { LEFT, BOTTOM, RIGHT, TOP };
+
+    // Column and row offsets to the tile across each side
+    constexpr int SIDE_COL_OFFSETS[4] = { -1, 0, 1, 0 };
+    constexpr int SIDE_ROW_OFFSETS[4] = { 0, 1, 0, -1 };
+
+    // Corner each side starts at (column and row offsets from the tile's top left corner)
+    constexpr int START_COL_OFFSETS[4] = { 0, 0, 1, 1 };
+    constexpr int START_ROW_OFFSETS[4] = { 0, 1, 1, 0 };
+
+    // An edge of an outline, the side of a wall tile that faces a non-wall tile
+    struct Edge
+    {
+        int mRow;
+        int mCol;
+        int mSide;
+
+        bool operator==(const Edge& edge) const { return mRow == edge.mRow && mCol == edge.mCol && mSide == edge.mSide; }
+    };
+
+    // Tiles outside of the map aren't walls
+    bool isWall(const TileGrid& tiles, int row, int col)
+    {
+        return row >= 0 && row < tiles.getHeight() && col >= 0 && col < tiles.getWidth() && tiles.isWall(row, col);
+    }
+
+    // Marching squares, the 2x2 block of tiles around the corner an edge ends at decides where the outline goes next
+    Edge findNextEdge(const TileGrid& tiles, const Edge& edge)
+    {
+        // Outlines travel along a side in the direction of the next side's outward offset
+        int next = (edge.mSide + 1) % 4;
+
+        // The tile ahead, and the tile diagonally ahead on the outer side of the edge
+        int aheadRow = edge.mRow + SIDE_ROW_OFFSETS[next];
+        int aheadCol = edge.mCol + SIDE_COL_OFFSETS[next];
+        int diagonalRow = aheadRow + SIDE_ROW_OFFSETS[edge.mSide];
+        int diagonalCol = aheadCol + SIDE_COL_OFFSETS[edge.mSide];
+
+        // Nothing ahead, turn around the corner of the tile
+        // This also splits diagonal walls since the outline never crosses over to the diagonal tile
+        if (!isWall(tiles, aheadRow, aheadCol))
+            return Edge{ edge.mRow, edge.mCol, next };
+
+        // Inner corner, turn onto the diagonal tile
+        if (isWall(tiles, diagonalRow, diagonalCol))
+            return Edge{ diagonalRow, diagonalCol, (edge.mSide + 3) % 4 };
+
+        // Straight wall, carry on along the tile ahead
+        return Edge{ aheadRow, aheadCol, edge.mSide };
+    }
+}
+
+namespace WallGeometry
+{
+    std::vector<std::vector<Vec>> traceOutlines(const TileGrid& tiles, int tileSideLength)
+    {
+        std::vector<std::vector<Vec>> outlines;
+
+        // 1 bit per side of every tile, set once the side is part of an outline
+        std::vector<Uint8> tracedSides(static_cast<size_t>(tiles.size()), 0);
+
+        for (int iRow = 0; iRow < tiles.getHeight(); ++iRow)
+        {
+            for (int iCol = 0; iCol < tiles.getWidth(); ++iCol)
+            {
+                if (!tiles.isWall(iRow, iCol))
+                    continue;
+
+                for (int iSide = LEFT; iSide <= TOP; ++iSide)
+                {
+                    // Only sides facing a non-wall tile are edges
+                    if (isWall(tiles, iRow + SIDE_ROW_OFFSETS[iSide], iCol + SIDE_COL_OFFSETS[iSide]))
+                        continue;
+
+                    if (tracedSides[tiles.getIndex(iRow, iCol)] & (1 << iSide))
+                        continue;
+
+                    // Follow the outline until it's back at the first edge
+                    // Vertices are only added when the side changes, so straight runs of tiles don't leave collinear vertices behind
+                    std::vector<Vec> outline;
+                    Edge first{ iRow, iCol, iSide };
+                    Edge current = first;
+
+                    do
+                    {
+                        tracedSides[tiles.getIndex(current.mRow, current.mCol)] |= (1 << current.mSide);
+
+                        Edge next = findNextEdge(tiles, current);
+                        if (next.mSide != current.mSide)
+                        {
+                            outline.emplace_back(static_cast<float>((next.mCol + START_COL_OFFSETS[next.mSide]) * tileSideLength),
+                                static_cast<float>((next.mRow + START_ROW_OFFSETS[next.mSide]) * tileSideLength));
+                        }
+
+                        current = next;
+                    } while (!(current == first));
+
+                    outlines.push_back(std::move(outline));
+                }
+            }
+        }
+
+        return outlines;
+    }
+
+    std::vector<ConvexPolygon> decompose(const std::vector<std::vector<Vec>>& outlines)
+    {
+        // Outlines are axis aligned, only their vertical edges are needed to find what's inside
+        struct VerticalEdge
+        {
+            float mX;
+            float mTop;
+            float mBottom;
+        };
+
+        std::vector<VerticalEdge> edges;
+        std::vector<float> bandEdges;
+
+        for (auto& outline : outlines)
+        {
+            for (size_t i = 0; i < outline.size(); ++i)
+            {
+                const Vec& v0 = outline[i];
+                const Vec& v1 = outline[(i + 1) % outline.size()];
+
+                if (v0.getX() != v1.getX())
+                    continue;
+
+                edges.push_back(VerticalEdge{ v0.getX(), std::min(v0.getY(), v1.getY()), std::max(v0.getY(), v1.getY()) });
+                bandEdges.push_back(v0.getY());
+                bandEdges.push_back(v1.getY());
+            }
+        }
+
+        std::sort(edges.begin(), edges.end(), [](const VerticalEdge& a, const VerticalEdge& b) { return a.mTop < b.mTop; });
+        std::sort(bandEdges.begin(), bandEdges.end());
+        bandEdges.erase(std::unique(bandEdges.begin(), bandEdges.end()), bandEdges.end());
+
+        // A rectangle still being extended downwards
+        struct OpenRect
+        {
+            float mLeft;
+            float mRight;
+            float mTop;
+        };
+
+        std::vector<ConvexPolygon> rects;
+        std::vector<OpenRect> open;
+        std::vector<OpenRect> stillOpen;
+        std::vector<VerticalEdge> active;   // Edges crossing the current band
+        std::vector<float> crossings;       // X of every active edge, sorted
+        size_t nextEdge = 0;
+
+        auto close = [&rects](const OpenRect& rect, float bottom)
+        {
+            rects.emplace_back(std::vector<Vec>{ { rect.mLeft, rect.mTop }, { rect.mLeft, bottom }, { rect.mRight, bottom }, { rect.mRight, rect.mTop } });
+        };
+
+        // Sweep down the horizontal bands between consecutive vertex heights, the outline is a straight run of vertical edges in each band
+        for (size_t iBand = 0; iBand + 1 < bandEdges.size(); ++iBand)
+        {
+            float top = bandEdges[iBand];
+
+            // Drop the edges that ended above the band and add the ones starting at its top
+            active.erase(std::remove_if(active.begin(), active.end(), [top](const VerticalEdge& edge) { return edge.mBottom <= top; }), active.end());
+            while (nextEdge < edges.size() && edges[nextEdge].mTop <= top)
+                active.push_back(edges[nextEdge++]);
+
+            crossings.clear();
+            for (auto& edge : active)
+                crossings.push_back(edge.mX);
+            std::sort(crossings.begin(), crossings.end());
+
+            // Outlines don't cross, so every other gap between crossings is inside a wall
+            // Spans matching a rectangle from the band above extend it, the rest start new rectangles
+            stillOpen.clear();
+            size_t iOpen = 0;
+            for (size_t iCrossing = 0; iCrossing + 1 < crossings.size(); iCrossing += 2)
+            {
+                float left = crossings[iCrossing];
+                float right = crossings[iCrossing + 1];
+
+                while (iOpen < open.size() && open[iOpen].mLeft < left)
+                    close(open[iOpen++], top);
+
+                if (iOpen < open.size() && open[iOpen].mLeft == left && open[iOpen].mRight == right)
+                    stillOpen.push_back(open[iOpen++]);
+                else
+                    stillOpen.push_back(OpenRect{ left, right, top });
+            }
+
+            while (iOpen < open.size())
+                close(open[iOpen++], top);
+
+            open.swap(stillOpen);
+        }
+
+        // Nothing is open past the last band
+        for (auto& rect : open)
+            close(rect, bandEdges.back());
+
+        return rects;
+    }
+}
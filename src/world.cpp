@@ -0,0 +1,779 @@
+#include "../header/world.h"
+#include "../header/components/component.h"
+#include "../header/entity.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+using namespace WorldInternals;
+
+// Spawned entities are stored in slots of this size, a free slot holds a pointer to the next free slot
+constexpr std::size_t ENTITY_SLOT_SIZE = std::max(sizeof(Entity), sizeof(void*));
+
+// For warnings, by UpdatePhase
+constexpr const char* UPDATE_PHASE_NAMES[UPDATE_PHASE_COUNT] = { "update1", "integrate", "update2", "update3" };
+
+BlockPool::~BlockPool()
+{
+	// Columns have already given their blocks back
+	for (std::byte* block : mFreeBlocks)
+		::operator delete(block, std::align_val_t{ mType->mAlign });
+}
+
+std::byte* BlockPool::allocate()
+{
+	if (!mFreeBlocks.empty())
+	{
+		std::byte* block = mFreeBlocks.back();
+		mFreeBlocks.pop_back();
+		return block;
+	}
+
+	++mBlockCount;
+	return static_cast<std::byte*>(::operator new(mType->mSize * COMPONENTS_PER_BLOCK, std::align_val_t{ mType->mAlign }));
+}
+
+void BlockPool::release(std::byte* block)
+{
+	mFreeBlocks.push_back(block);
+}
+
+void BlockPool::shrink()
+{
+	for (std::byte* block : mFreeBlocks)
+		::operator delete(block, std::align_val_t{ mType->mAlign });
+
+	mBlockCount -= static_cast<int>(mFreeBlocks.size());
+	mFreeBlocks.clear();
+}
+
+ComponentColumn::ComponentColumn(ComponentColumn&& other) noexcept : mType{ other.mType }, mPool{ other.mPool }, mBlocks{ std::move(other.mBlocks) }, mSize{ other.mSize }
+{
+	other.mBlocks.clear();
+	other.mSize = 0;
+}
+
+ComponentColumn::~ComponentColumn()
+{
+	for (int iRow = 0; iRow < mSize; ++iRow)
+	{
+		mType->mDestroy(get(iRow));
+		mPool->removeLive();
+	}
+
+	for (std::byte* block : mBlocks)
+		mPool->release(block);
+}
+
+void* ComponentColumn::pushBack()
+{
+	// Add a block once the last one is full
+	if (mSize == static_cast<int>(mBlocks.size()) * COMPONENTS_PER_BLOCK)
+		mBlocks.push_back(mPool->allocate());
+
+	mPool->addLive();
+	return get(mSize++);
+}
+
+void ComponentColumn::removeSwap(int row)
+{
+	int last = mSize - 1;
+
+	mType->mDestroy(get(row));
+	if (row != last)
+	{
+		mType->mMoveConstruct(get(row), get(last));
+		mType->mDestroy(get(last));
+	}
+
+	--mSize;
+	mPool->removeLive();
+
+	if (mSize <= (static_cast<int>(mBlocks.size()) - 2) * COMPONENTS_PER_BLOCK)
+	{
+		mPool->release(mBlocks.back());
+		mBlocks.pop_back();
+	}
+}
+
+void ComponentColumn::shrink()
+{
+	if (mSize <= (static_cast<int>(mBlocks.size()) - 1) * COMPONENTS_PER_BLOCK)
+	{
+		mPool->release(mBlocks.back());
+		mBlocks.pop_back();
+	}
+}
+
+World::World(int workerCount)
+{
+	if (workerCount > 0)
+		mJobs = std::make_unique<JobSystem>(workerCount);
+
+	mArchetypes.push_back(std::make_unique<Archetype>());
+	mEmptyArchetype = mArchetypes.back().get();
+}
+
+World::~World()
+{
+	// Entities go first, they remove themselves from the archetypes
+	for (auto& record : mEntities)
+	{
+		if (record.mEntity != nullptr)
+			record.mEntity->~Entity();
+	}
+
+	// Components are destroyed with their columns, before the pools their blocks return to
+	mArchetypes.clear();
+}
+
+int World::createEntity(Entity* entity)
+{
+	int id;
+	if (mFreeIds.empty())
+	{
+		if (mEntities.size() > ENTITY_ID_MASK)
+			throw(std::length_error{ "Error: Exceeded the maximum number of entities\n" });
+
+		id = static_cast<int>(mEntities.size());
+		mEntities.emplace_back();
+	}
+	else
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}
+
+	EntityRecord& record = mEntities[id];
+	record.mEntity = entity;
+	record.mArchetype = mEmptyArchetype;
+	record.mRow = static_cast<int>(mEmptyArchetype->mEntities.size());
+	mEmptyArchetype->mEntities.push_back(id);
+
+	return id;
+}
+
+void World::destroyEntity(int id)
+{
+	EntityRecord& record = mEntities[id];
+
+	for (auto& column : record.mArchetype->mColumns)
+		column.removeSwap(record.mRow);
+	removeRow(*record.mArchetype, record.mRow);
+
+	// Handles to the old entity stop matching, 0 is skipped so the default handle never matches
+	Uint32 generation = (record.mGeneration + 1) % ENTITY_GENERATION_COUNT;
+	record = EntityRecord{};
+	record.mGeneration = generation == 0 ? 1 : generation;
+
+	mFreeIds.push_back(id);
+}
+
+Entity& World::spawnEntity()
+{
+	// Start a new slab once every slot is in use, its slots are linked onto the free list
+	if (mFreeEntity == nullptr)
+	{
+		mEntitySlabs.emplace_back(new std::byte[ENTITY_SLOT_SIZE * ENTITIES_PER_SLAB]);
+		std::byte* slab = mEntitySlabs.back().get();
+
+		for (int iSlot = ENTITIES_PER_SLAB - 1; iSlot >= 0; --iSlot)
+		{
+			void* slot = slab + iSlot * ENTITY_SLOT_SIZE;
+			*static_cast<void**>(slot) = mFreeEntity;
+			mFreeEntity = slot;
+		}
+	}
+
+	void* slot = mFreeEntity;
+	mFreeEntity = *static_cast<void**>(slot);
+
+	Entity* entity = new (slot) Entity{ *this };
+
+	mPeakEntities = std::max(mPeakEntities, getEntityCount());
+	return *entity;
+}
+
+void World::despawnEntity(Entity& entity)
+{
+	void* slot = &entity;
+	entity.~Entity();
+
+	*static_cast<void**>(slot) = mFreeEntity;
+	mFreeEntity = slot;
+}
+
+Entity* World::getEntity(EntityHandle handle) const
+{
+	int id = handle.getId();
+	if (id >= static_cast<int>(mEntities.size()) || mEntities[id].mGeneration != handle.getGeneration())
+		return nullptr;
+
+	return mEntities[id].mEntity;
+}
+
+void World::destroyLater(int id)
+{
+	std::lock_guard<std::mutex> lock{ mDestroyQueueMutex };
+
+	if (mEntities[id].mQueued)
+		return;
+
+	mEntities[id].mQueued = true;
+	mDestroyQueue.push_back(id);
+}
+
+void World::destroyQueued()
+{
+	if (mDestroyQueue.empty())
+		return;
+
+	// Destroying an entity can't queue more, its components are already gone
+	for (int id : mDestroyQueue)
+		despawnEntity(*mEntities[id].mEntity);
+	mDestroyQueue.clear();
+}
+
+void World::compact()
+{
+	for (auto& archetype : mArchetypes)
+	{
+		for (auto& column : archetype->mColumns)
+			column.shrink();
+	}
+
+	for (auto& pool : mPools)
+	{
+		if (pool != nullptr)
+			pool->shrink();
+	}
+
+	// Mark the slots in use, slabs are sorted so an entity's slab can be found by its address
+	std::sort(mEntitySlabs.begin(), mEntitySlabs.end());
+	std::vector<bool> slotUsed(mEntitySlabs.size() * ENTITIES_PER_SLAB, false);
+
+	for (auto& record : mEntities)
+	{
+		if (record.mEntity == nullptr)
+			continue;
+
+		std::byte* address = reinterpret_cast<std::byte*>(record.mEntity);
+		auto slab = std::upper_bound(mEntitySlabs.begin(), mEntitySlabs.end(), address, [](std::byte* address, const std::unique_ptr<std::byte[]>& slab) { return address < slab.get(); }) - 1;
+		slotUsed[(slab - mEntitySlabs.begin()) * ENTITIES_PER_SLAB + (address - slab->get()) / ENTITY_SLOT_SIZE] = true;
+	}
+
+	// Free the empty slabs, then rebuild the free list from the free slots of the rest
+	std::vector<std::unique_ptr<std::byte[]>> keptSlabs;
+	mFreeEntity = nullptr;
+
+	for (int iSlab = static_cast<int>(mEntitySlabs.size()) - 1; iSlab >= 0; --iSlab)
+	{
+		auto firstSlot = slotUsed.begin() + iSlab * ENTITIES_PER_SLAB;
+		if (std::find(firstSlot, firstSlot + ENTITIES_PER_SLAB, true) == firstSlot + ENTITIES_PER_SLAB)
+			continue;
+
+		for (int iSlot = ENTITIES_PER_SLAB - 1; iSlot >= 0; --iSlot)
+		{
+			if (firstSlot[iSlot])
+				continue;
+
+			void* slot = mEntitySlabs[iSlab].get() + iSlot * ENTITY_SLOT_SIZE;
+			*static_cast<void**>(slot) = mFreeEntity;
+			mFreeEntity = slot;
+		}
+
+		keptSlabs.push_back(std::move(mEntitySlabs[iSlab]));
+	}
+
+	mEntitySlabs = std::move(keptSlabs);
+	mUpdatesSinceCompact = 0;
+}
+
+PoolStats World::getComponentStats(typeID id) const
+{
+	PoolStats stats;
+	if (mPools[id] != nullptr)
+	{
+		stats.mLive = mPools[id]->getLive();
+		stats.mPeak = mPools[id]->getPeak();
+		stats.mCapacity = mPools[id]->getBlockCount() * COMPONENTS_PER_BLOCK;
+	}
+	return stats;
+}
+
+PoolStats World::getEntityStats() const
+{
+	return PoolStats{ getEntityCount(), mPeakEntities, static_cast<int>(mEntitySlabs.size()) * ENTITIES_PER_SLAB };
+}
+
+void World::saveSnapshot(std::vector<std::uint8_t>& snapshot) const
+{
+	snapshot.clear();
+	SnapshotWriter writer{ snapshot };
+
+	// Counts are filled in at the end
+	SnapshotFormat::Header header{};
+	std::memcpy(header.mMagic, SnapshotFormat::MAGIC, sizeof(SnapshotFormat::MAGIC));
+	header.mVersion = SnapshotFormat::VERSION;
+	header.mEntityCount = static_cast<std::uint32_t>(getEntityCount());
+	writer.write(header);
+
+	for (auto& archetype : mArchetypes)
+	{
+		if (archetype->mEntities.empty())
+			continue;
+		++header.mArchetypeCount;
+
+		std::uint32_t savedColumnCount = 0;
+		for (auto& column : archetype->mColumns)
+		{
+			if (column.getType().mSaveRows != nullptr)
+				++savedColumnCount;
+		}
+
+		writer.write(archetype->mMask);
+		writer.write(static_cast<std::uint32_t>(archetype->mEntities.size()));
+		writer.write(savedColumnCount);
+		for (int id : archetype->mEntities)
+			writer.write(getHandle(id).mValue);
+
+		for (auto& column : archetype->mColumns)
+		{
+			const ComponentType& type = column.getType();
+			if (type.mSaveRows == nullptr)
+				continue;
+
+			writer.write(static_cast<std::uint32_t>(type.mId));
+			std::size_t sizeOffset = writer.getOffset();
+			writer.write(std::uint32_t{ 0 });
+
+			// Rows are only stored back to back within a block
+			for (int iRow = 0; iRow < column.size(); iRow += COMPONENTS_PER_BLOCK)
+				type.mSaveRows(column.get(iRow), std::min(COMPONENTS_PER_BLOCK, column.size() - iRow), writer);
+
+			writer.writeAt(sizeOffset, static_cast<std::uint32_t>(writer.getOffset() - sizeOffset - sizeof(std::uint32_t)));
+		}
+	}
+
+	writer.writeAt(0, header);
+}
+
+bool World::checkSnapshot(const std::uint8_t* data, std::size_t size) const
+{
+	SnapshotReader reader{ data, size };
+
+	// Not a snapshot, or written by an incompatible version
+	SnapshotFormat::Header header;
+	if (!reader.read(header) || std::memcmp(header.mMagic, SnapshotFormat::MAGIC, sizeof(SnapshotFormat::MAGIC)) != 0 || header.mVersion != SnapshotFormat::VERSION)
+	{
+		fprintf(stderr, "Failed to restore snapshot: it isn't a snapshot of this version\n");
+		return false;
+	}
+
+	// Every entity in the snapshot must still exist, so there can't be any more than there were
+	if (header.mEntityCount != static_cast<std::uint32_t>(getEntityCount()))
+	{
+		fprintf(stderr, "Failed to restore snapshot: it has %u entities, the world has %d\n", header.mEntityCount, getEntityCount());
+		return false;
+	}
+
+	for (std::uint32_t iArchetype = 0; iArchetype < header.mArchetypeCount && !reader.hasFailed(); ++iArchetype)
+	{
+		ComponentMask mask = 0;
+		std::uint32_t entityCount = 0;
+		std::uint32_t columnCount = 0;
+		reader.read(mask);
+		reader.read(entityCount);
+		reader.read(columnCount);
+
+		const Archetype* archetype = nullptr;
+		for (std::uint32_t iEntity = 0; iEntity < entityCount && !reader.hasFailed(); ++iEntity)
+		{
+			EntityHandle handle;
+			if (!reader.read(handle.mValue))
+				break;
+
+			const EntityRecord* record = handle.getId() < static_cast<int>(mEntities.size()) ? &mEntities[handle.getId()] : nullptr;
+			if (record == nullptr || record->mGeneration != handle.getGeneration() || record->mArchetype == nullptr || record->mArchetype->mMask != mask)
+			{
+				fprintf(stderr, "Failed to restore snapshot: entity %d has been destroyed or had components added since it was saved\n", handle.getId());
+				return false;
+			}
+			archetype = record->mArchetype;
+		}
+
+		for (std::uint32_t iColumn = 0; iColumn < columnCount && !reader.hasFailed(); ++iColumn)
+		{
+			std::uint32_t typeId = 0;
+			std::uint32_t columnSize = 0;
+			reader.read(typeId);
+			reader.read(columnSize);
+
+			int column = archetype != nullptr && typeId < MAX_COMPONENT_TYPES ? archetype->findColumn(static_cast<typeID>(typeId)) : -1;
+			if (column == -1 || archetype->mColumns[column].getType().mLoadRows == nullptr)
+			{
+				fprintf(stderr, "Failed to restore snapshot: it has state for a component type the entities don't have\n");
+				return false;
+			}
+
+			// Every component's state is read through once here, so restoring can't stop part way
+			const std::uint8_t* columnData = reader.readBytes(columnSize);
+			if (columnData == nullptr)
+				break;
+
+			SnapshotReader columnReader{ columnData, columnSize };
+			if (!archetype->mColumns[column].getType().mCheckRows(static_cast<int>(entityCount), columnReader) || columnReader.hasFailed() || columnReader.getRemaining() != 0)
+			{
+				fprintf(stderr, "Failed to restore snapshot: the state of component type %u is corrupt\n", typeId);
+				return false;
+			}
+		}
+	}
+
+	if (reader.hasFailed() || reader.getRemaining() != 0)
+	{
+		fprintf(stderr, "Failed to restore snapshot: it's corrupt\n");
+		return false;
+	}
+	return true;
+}
+
+bool World::loadSnapshot(const std::uint8_t* data, std::size_t size)
+{
+	if (!checkSnapshot(data, size))
+		return false;
+
+	// Everything has been checked, so nothing below can fail
+	SnapshotReader reader{ data, size };
+	SnapshotFormat::Header header{};
+	reader.read(header);
+
+	for (std::uint32_t iArchetype = 0; iArchetype < header.mArchetypeCount; ++iArchetype)
+	{
+		ComponentMask mask = 0;
+		std::uint32_t entityCount = 0;
+		std::uint32_t columnCount = 0;
+		reader.read(mask);
+		reader.read(entityCount);
+		reader.read(columnCount);
+
+		const std::uint8_t* handles = reader.readBytes(entityCount * sizeof(Uint32));
+		if (entityCount == 0)
+			continue;
+
+		auto getId = [handles](std::uint32_t iEntity)
+		{
+			Uint32 value;
+			std::memcpy(&value, handles + iEntity * sizeof(Uint32), sizeof(Uint32));
+			return static_cast<int>(value & ENTITY_ID_MASK);
+		};
+
+		// Rows are still in the order they were saved in unless the entities were set up in a different order, then whole blocks are restored at once
+		Archetype& archetype = *mEntities[getId(0)].mArchetype;
+		bool sameRows = archetype.mEntities.size() == entityCount;
+		for (std::uint32_t iEntity = 0; iEntity < entityCount && sameRows; ++iEntity)
+			sameRows = archetype.mEntities[iEntity] == getId(iEntity);
+
+		for (std::uint32_t iColumn = 0; iColumn < columnCount; ++iColumn)
+		{
+			std::uint32_t typeId = 0;
+			std::uint32_t columnSize = 0;
+			reader.read(typeId);
+			reader.read(columnSize);
+
+			ComponentColumn& column = archetype.mColumns[archetype.findColumn(static_cast<typeID>(typeId))];
+			const ComponentType& type = column.getType();
+			SnapshotReader columnReader{ reader.readBytes(columnSize), columnSize };
+
+			if (sameRows)
+			{
+				for (int iRow = 0; iRow < column.size(); iRow += COMPONENTS_PER_BLOCK)
+					type.mLoadRows(column.get(iRow), std::min(COMPONENTS_PER_BLOCK, column.size() - iRow), columnReader);
+			}
+			else
+			{
+				for (std::uint32_t iEntity = 0; iEntity < entityCount; ++iEntity)
+					type.mLoadRows(column.get(mEntities[getId(iEntity)].mRow), 1, columnReader);
+			}
+		}
+	}
+
+	return true;
+}
+
+BlockPool& World::getPool(const ComponentType& type)
+{
+	if (mPools[type.mId] == nullptr)
+		mPools[type.mId] = std::make_unique<BlockPool>(type);
+
+	return *mPools[type.mId];
+}
+
+Archetype* World::getArchetypeWith(Archetype& archetype, const ComponentType& type)
+{
+	if (archetype.mAddEdges[type.mId] != nullptr)
+		return archetype.mAddEdges[type.mId];
+
+	ComponentMask mask = archetype.mMask | (ComponentMask{ 1 } << type.mId);
+
+	// Another path may have already created it
+	Archetype* destination = nullptr;
+	for (auto& existing : mArchetypes)
+	{
+		if (existing->mMask == mask)
+		{
+			destination = existing.get();
+			break;
+		}
+	}
+
+	if (destination == nullptr)
+	{
+		mArchetypes.push_back(std::make_unique<Archetype>());
+		destination = mArchetypes.back().get();
+		destination->mMask = mask;
+
+		destination->mTypes = archetype.mTypes;
+		destination->mTypes.insert(std::upper_bound(destination->mTypes.begin(), destination->mTypes.end(), &type,
+			[](const ComponentType* a, const ComponentType* b) { return a->mId < b->mId; }), &type);
+
+		for (int i = 0; i < static_cast<int>(destination->mTypes.size()); ++i)
+		{
+			destination->mColumns.emplace_back(*destination->mTypes[i], getPool(*destination->mTypes[i]));
+			destination->mColumnOfType[destination->mTypes[i]->mId] = static_cast<Sint8>(i);
+		}
+	}
+
+	archetype.mAddEdges[type.mId] = destination;
+	return destination;
+}
+
+void World::moveEntity(int id, Archetype& destination)
+{
+	EntityRecord& record = mEntities[id];
+	Archetype& source = *record.mArchetype;
+
+	// Move each component into the matching column, the source's rows are then closed up
+	for (auto& column : source.mColumns)
+	{
+		ComponentColumn& destColumn = destination.mColumns[destination.findColumn(column.getType().mId)];
+		column.getType().mMoveConstruct(destColumn.pushBack(), column.get(record.mRow));
+		column.removeSwap(record.mRow);
+	}
+	removeRow(source, record.mRow);
+
+	record.mArchetype = &destination;
+	record.mRow = static_cast<int>(destination.mEntities.size());
+	destination.mEntities.push_back(id);
+}
+
+void World::removeRow(Archetype& archetype, int row)
+{
+	// The last entity takes the removed row, like its components did
+	int last = static_cast<int>(archetype.mEntities.size()) - 1;
+	if (row != last)
+	{
+		archetype.mEntities[row] = archetype.mEntities[last];
+		mEntities[archetype.mEntities[row]].mRow = row;
+	}
+
+	archetype.mEntities.pop_back();
+}
+
+void World::handleEvents()
+{
+	forEveryComponent([](Component& component) { component.handleEvent(); });
+}
+
+void World::update(float deltaTime)
+{
+	// Every entity finishes a phase before any starts the next one
+	for (int iPhase = 0; iPhase < UPDATE_PHASE_COUNT; ++iPhase)
+	{
+		runPhase(static_cast<UpdatePhase>(iPhase), deltaTime);
+
+		for (auto& function : mAfterPhase[iPhase])
+			function(deltaTime);
+	}
+
+	destroyQueued();
+
+	if (++mUpdatesSinceCompact >= COMPACT_INTERVAL_UPDATES && getEntityStats().getFragmentation() > COMPACT_FRAGMENTATION)
+		compact();
+}
+
+void World::runPhase(UpdatePhase phase, float deltaTime)
+{
+	// The types in use, and for each type, the types it shares an entity with
+	ComponentMask present = 0;
+	std::array<ComponentMask, MAX_COMPONENT_TYPES> sharesEntity{};
+
+	for (auto& archetype : mArchetypes)
+	{
+		if (archetype->mEntities.empty())
+			continue;
+
+		present |= archetype->mMask;
+		for (const ComponentType* type : archetype->mTypes)
+			sharesEntity[type->mId] |= archetype->mMask;
+	}
+
+	// Two types can run at the same time unless one writes what the other reads or writes
+	// Own-entity access only conflicts between types that are on the same entity
+	auto conflicts = [&sharesEntity](const ComponentType& a, const ComponentType& b, UpdatePhase phase)
+	{
+		const SystemAccess& accessA = a.mAccess[phase];
+		const SystemAccess& accessB = b.mAccess[phase];
+
+		if ((accessA.mReadsOthers & accessB.mWrites) || (accessB.mReadsOthers & accessA.mWrites))
+			return true;
+
+		bool shareEntity = (sharesEntity[a.mId] >> b.mId) & 1;
+		return shareEntity && ((accessA.mWrites & (accessB.mReads | accessB.mWrites)) || (accessB.mWrites & accessA.mReads));
+	};
+
+	// Types are added to the batch in id order until one conflicts with it, then the batch is run
+	std::vector<const ComponentType*> batch;
+
+	for (int id = 0; id < MAX_COMPONENT_TYPES; ++id)
+	{
+		if (!((present >> id) & 1))
+			continue;
+
+		const ComponentType& type = mPools[id]->getType();
+		if (type.mUpdateRows[phase] == nullptr || (type.mDeclaresAccess && !type.mAccess[phase].mRuns))
+			continue;
+
+		if (const char* reason = getSerialReason(type, phase))
+		{
+			// Types meant for the calling thread aren't worth a warning, ones missing or conflicting with their own declaration are
+			bool intended = mJobs == nullptr || type.mAccess[phase].mMainThread || (type.mAccess[phase].mResources & mMainThreadResources);
+			if (!intended && !((mReportedConflicts >> id) & 1))
+			{
+				fprintf(stderr, "Warning: Component type %d runs %s on one thread, %s\n", id, UPDATE_PHASE_NAMES[phase], reason);
+				mReportedConflicts |= ComponentMask{ 1 } << id;
+			}
+
+			// Runs alone, after everything before it
+			runBatch(batch, phase, deltaTime);
+			batch.clear();
+			runBatch({ &type }, phase, deltaTime);
+			continue;
+		}
+
+		for (const ComponentType* batched : batch)
+		{
+			if (conflicts(type, *batched, phase))
+			{
+				runBatch(batch, phase, deltaTime);
+				batch.clear();
+				break;
+			}
+		}
+		batch.push_back(&type);
+	}
+
+	runBatch(batch, phase, deltaTime);
+}
+
+void World::runBatch(const std::vector<const ComponentType*>& batch, UpdatePhase phase, float deltaTime)
+{
+	// Rows are only stored back to back within a block
+	auto run = [phase, deltaTime](const ComponentColumn& column, int begin, int end)
+	{
+		for (int iRow = begin; iRow < end;)
+		{
+			int blockEnd = std::min(end, (iRow / COMPONENTS_PER_BLOCK + 1) * COMPONENTS_PER_BLOCK);
+			column.getType().mUpdateRows[phase](column.get(iRow), blockEnd - iRow, deltaTime);
+			iRow = blockEnd;
+		}
+	};
+
+	// Single types that can't be spread across threads run here
+	if (batch.size() == 1 && getSerialReason(*batch[0], phase) != nullptr)
+	{
+		for (auto& archetype : mArchetypes)
+		{
+			int column = archetype->findColumn(batch[0]->mId);
+			if (column != -1)
+				run(archetype->mColumns[column], 0, archetype->mColumns[column].size());
+		}
+		return;
+	}
+
+	// Split every column of the batch's types into jobs
+	struct Job
+	{
+		const ComponentColumn* mColumn;
+		int mBegin;
+		int mEnd;
+	};
+
+	std::vector<Job> jobs;
+	for (const ComponentType* type : batch)
+	{
+		for (auto& archetype : mArchetypes)
+		{
+			int column = archetype->findColumn(type->mId);
+			if (column == -1)
+				continue;
+
+			const ComponentColumn& rows = archetype->mColumns[column];
+			for (int iRow = 0; iRow < rows.size(); iRow += ROWS_PER_JOB)
+				jobs.push_back(Job{ &rows, iRow, std::min(iRow + ROWS_PER_JOB, rows.size()) });
+		}
+	}
+
+	// Without worker threads every type runs alone, so this is only reached with an empty batch
+	parallelFor(static_cast<int>(jobs.size()), 1, [&jobs, &run](int begin, int end)
+		{
+			for (int iJob = begin; iJob < end; ++iJob)
+				run(*jobs[iJob].mColumn, jobs[iJob].mBegin, jobs[iJob].mEnd);
+		});
+}
+
+void World::parallelFor(int count, int grainSize, const std::function<void(int begin, int end)>& function)
+{
+	if (mJobs == nullptr)
+	{
+		if (count > 0)
+			function(0, count);
+		return;
+	}
+
+	mJobs->parallelFor(count, grainSize, function);
+}
+
+const char* World::getSerialReason(const ComponentType& type, UpdatePhase phase) const
+{
+	const SystemAccess& access = type.mAccess[phase];
+
+	if (mJobs == nullptr)
+		return "there are no worker threads";
+	if (!type.mDeclaresAccess)
+		return "it doesn't declare its access";
+	if (access.mMainThread)
+		return "it must run on the main thread";
+	if (access.mResources & mMainThreadResources)
+		return "it uses a resource that's limited to the main thread";
+	if (access.mWrites & access.mReadsOthers)
+		return "it reads other entities' components of a type it writes";
+
+	return nullptr;
+}
+
+void World::draw(float interpolation)
+{
+	forEveryComponent([interpolation](Component& component) { component.draw(interpolation); });
+}
@@ -0,0 +1,31 @@
+#include "../header/map_format.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+
+// Converts a text tile map into the binary map format
+// Usage: map_converter <input text map> <output binary map> [--compress]
+int main(int argc, char* args[])
+{
+	if (argc < 3 || argc > 4 || (argc == 4 && strcmp(args[3], "--compress") != 0))
+	{
+		fprintf(stderr, "Usage: map_converter <input text map> <output binary map> [--compress]\n");
+		return -1;
+	}
+
+	std::string inputPath{ args[1] };
+	std::string outputPath{ args[2] };
+	bool compress = argc == 4;
+
+	MapFormat::MapData map;
+	if (MapFormat::readTextMap(inputPath, map) == false)
+		return -1;
+
+	if (MapFormat::writeBinaryMap(outputPath, map, compress) == false)
+		return -1;
+
+	printf("Converted %s (%d x %d tiles) to %s%s\n", inputPath.c_str(), map.mWidthInTiles, map.mHeightInTiles, outputPath.c_str(), compress ? " (chunk compressed)" : "");
+	return 0;
+}